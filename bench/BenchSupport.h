@@ -0,0 +1,93 @@
+#pragma once
+
+#include "choc/audio/choc_AudioSampleData.h"
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Shared by the benchmark and stress tools: their test audio and the JSON they write
+namespace bench
+{
+    // Low-level noise, so every bit depth has non-trivial data to convert. Seeded:
+    // a fresh generator always produces the same samples.
+    class NoiseGenerator
+    {
+    public:
+        void fill(const choc::buffer::ChannelArrayView<float>& view)
+        {
+            for (uint32_t channel = 0; channel < view.getNumChannels(); ++channel)
+                for (uint32_t frame = 0; frame < view.getNumFrames(); ++frame)
+                    view.getSample(channel, frame) = noise(random);
+        }
+
+    private:
+        std::minstd_rand random{12345};
+        std::uniform_real_distribution<float> noise{-0.5f, 0.5f};
+    };
+
+    // One JSON object, built a field at a time. Written on one line, or with a
+    // field per line for the top level of a results file.
+    class JsonObject
+    {
+    public:
+        JsonObject& addString(const std::string& key, const std::string& value) { return addRaw(key, "\"" + value + "\""); }
+        JsonObject& addCount(const std::string& key, uint64_t value) { return addRaw(key, std::to_string(value)); }
+
+        JsonObject& addNumber(const std::string& key, double value, int precision = 6)
+        {
+            std::ostringstream text;
+            text << std::setprecision(precision) << value;
+            return addRaw(key, text.str());
+        }
+
+        // 'json' is already JSON: null, a nested object or array
+        JsonObject& addRaw(const std::string& key, std::string json)
+        {
+            fields.emplace_back(key, std::move(json));
+            return *this;
+        }
+
+        // An array with one object per line, under a field of the top level
+        JsonObject& addArray(const std::string& key, const std::vector<JsonObject>& items)
+        {
+            std::string json = "[\n";
+            for (size_t i = 0; i < items.size(); ++i)
+                json += "    " + items[i].toString() + (i + 1 < items.size() ? ",\n" : "\n");
+            return addRaw(key, json + "  ]");
+        }
+
+        // This object's fields, appended to the end
+        JsonObject& addFields(const JsonObject& other)
+        {
+            fields.insert(fields.end(), other.fields.begin(), other.fields.end());
+            return *this;
+        }
+
+        std::string toString(bool fieldPerLine = false) const
+        {
+            const char* separator = fieldPerLine ? ",\n  " : ", ";
+            std::string json = fieldPerLine ? "{\n  " : "{ ";
+            for (size_t i = 0; i < fields.size(); ++i)
+                json += (i ? separator : "") + ("\"" + fields[i].first + "\": ") + fields[i].second;
+            return json + (fieldPerLine ? "\n}\n" : " }");
+        }
+
+    private:
+        std::vector<std::pair<std::string, std::string>> fields;
+    };
+
+    inline bool writeJsonFile(const std::string& path, const JsonObject& results)
+    {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+
+        out << results.toString(true);
+        return bool(out);
+    }
+}
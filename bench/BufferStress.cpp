@@ -0,0 +1,296 @@
+// Buffer-health stress runs: the player streams from simulated storage (an
+// in-memory file behind a throttled, fault-injecting reader) while this thread
+// stands in for the audio callback, and each storage profile is played at a
+// rising series of fixed buffer depths. The smallest depth that gets through
+// without an underrun is what that storage needs. Writes JSON (default
+// stress.json) alongside the table:
+//
+//   consoleAudioPlayerStress [--quick] [--profile NAME] [--json stress.json]
+//
+// Faults are seeded. They are drawn per read, though, and how many reads the
+// loader makes depends on how it is scheduled, so two runs see similar faults
+// rather than identical ones. Time runs 'timeScale' times faster than real - the
+// simulated device and its stalls are sped up by the same factor. Depth
+// adaptation is off (it measures stalls in wall-clock time).
+
+#include "BenchSupport.h"
+#include "BufferedAudioFilePlayer.h"
+#include "AudioReader.h"
+#include "RealtimeLogger.h"
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct StorageProfile
+    {
+        std::string name;
+        double megabytesPerSecond = 0.0;  // 0 = unthrottled
+        double accessSeconds = 0.0;       // Per read, before the transfer
+        FaultInjectingAudioReader::Options faults;
+        bool withReplica = false;         // Give the player a second copy to fail over to
+    };
+
+    struct RunResult
+    {
+        std::string profile;
+        double depthSeconds = 0.0;
+        uint64_t underruns = 0;
+        uint64_t underrunFrames = 0;
+        double minFillSeconds = 0.0;
+        uint64_t stalls = 0;
+        uint64_t readErrors = 0;
+        uint64_t failovers = 0;
+    };
+
+    struct StressOptions
+    {
+        double audioSeconds = 60.0;  // Played per run
+        double timeScale = 8.0;
+        double sampleRate = 48000.0;
+        uint32_t numChannels = 6;
+        uint32_t blockSize = 256;
+        std::string onlyProfile;
+    };
+
+    std::vector<StorageProfile> getProfiles()
+    {
+        std::vector<StorageProfile> profiles;
+
+        auto add = [&] (std::string name, double megabytesPerSecond, double accessSeconds)
+        {
+            StorageProfile profile;
+            profile.name = std::move(name);
+            profile.megabytesPerSecond = megabytesPerSecond;
+            profile.accessSeconds = accessSeconds;
+            profiles.push_back(profile);
+            return &profiles.back();
+        };
+
+        add("ram", 0.0, 0.0);
+        add("ssd", 200.0, 0.0001);
+
+        auto* sdCard = add("sdCard", 12.0, 0.001);           // Garbage collection pauses
+        sdCard->faults.stallProbability = 0.01;
+        sdCard->faults.stallSeconds = 0.4;
+
+        auto* usbDisk = add("usbDisk", 30.0, 0.012);         // Head parking / spin-up
+        usbDisk->faults.stallProbability = 0.002;
+        usbDisk->faults.stallSeconds = 1.2;
+
+        auto* networkShare = add("networkShare", 8.0, 0.005);  // Retransmits and the odd failed read
+        networkShare->faults.stallProbability = 0.005;
+        networkShare->faults.stallSeconds = 1.5;
+        networkShare->faults.errorProbability = 0.001;
+
+        auto* failover = add("mediaFailure", 30.0, 0.001);   // Dies 10 s in; the replica takes over
+        failover->faults.failFromFrame = 480000;
+        failover->withReplica = true;
+
+        return profiles;
+    }
+
+    // Built again for each run so no run depends on another
+    choc::buffer::ChannelArrayBuffer<float> createNoise(uint32_t numChannels, uint32_t numFrames)
+    {
+        choc::buffer::ChannelArrayBuffer<float> buffer(choc::buffer::Size::create(numChannels, numFrames));
+        bench::NoiseGenerator().fill(buffer.getView());
+        return buffer;
+    }
+
+    RunResult runProfile(const StorageProfile& profile, double depthSeconds, const StressOptions& options)
+    {
+        RunResult result;
+        result.profile = profile.name;
+        result.depthSeconds = depthSeconds;
+
+        // A 20 s file, so the longer runs loop it too
+        auto memory = std::make_unique<MemoryAudioReader>(createNoise(options.numChannels, (uint32_t)(20.0 * options.sampleRate)),
+                                                          options.sampleRate);
+        auto throttled = std::make_unique<ThrottledAudioReader>(std::move(memory), profile.megabytesPerSecond * 1e6,
+                                                                profile.accessSeconds, options.timeScale);
+        auto faultOptions = profile.faults;
+        faultOptions.timeScale = options.timeScale;
+        auto faulty = std::make_unique<FaultInjectingAudioReader>(std::move(throttled), faultOptions);
+        auto* faults = faulty.get();
+
+        BufferedAudioFilePlayer player(std::move(faulty), options.sampleRate);
+        if (!player.isLoaded())
+        {
+            std::cerr << "Error: " << player.getErrorMessage() << std::endl;
+            return result;
+        }
+
+        player.setBufferLimits(depthSeconds, depthSeconds);
+        if (profile.withReplica)
+            player.setReplicaPaths({ "replica" });
+        player.startPlayback(true);
+        player.takeMinBufferFill();
+
+        // Pull blocks at the scaled audio rate, like a callback would
+        choc::buffer::ChannelArrayBuffer<float> output(choc::buffer::Size::create(options.numChannels, options.blockSize));
+        auto view = output.getView();
+        auto totalFrames = static_cast<uint64_t>(options.audioSeconds * options.sampleRate);
+        uint64_t playedFrames = 0;
+        auto started = Clock::now();
+
+        while (playedFrames < totalFrames)
+        {
+            double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+            auto dueFrames = std::min(totalFrames, static_cast<uint64_t>(elapsed * options.timeScale * options.sampleRate));
+            while (playedFrames + options.blockSize <= dueFrames)
+            {
+                player.processBlock(view);
+                playedFrames += options.blockSize;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        const auto& stats = player.getStats();
+        result.underruns = stats.underruns.load();
+        result.underrunFrames = stats.underrunFrames.load();
+        result.minFillSeconds = player.takeMinBufferFill() / (double)options.numChannels / options.sampleRate;
+        result.stalls = faults->getStalls();
+        result.readErrors = stats.readErrors.load();
+        result.failovers = stats.failovers.load();
+        return result;
+    }
+
+    void printResult(const RunResult& r)
+    {
+        std::cerr << std::left << std::setw(14) << r.profile << std::right << std::fixed
+                  << std::setprecision(2) << std::setw(7) << r.depthSeconds << " s"
+                  << std::setw(10) << r.underruns << " underruns"
+                  << std::setw(10) << r.underrunFrames << " frames"
+                  << std::setprecision(3) << std::setw(9) << r.minFillSeconds << " s min fill"
+                  << std::setw(6) << r.stalls << " stalls"
+                  << std::setw(6) << r.readErrors << " errors"
+                  << std::setw(4) << r.failovers << " failovers" << std::endl;
+    }
+
+    bool writeJson(const std::string& path, const StressOptions& options, const std::vector<RunResult>& runs,
+                   const std::vector<std::pair<std::string, double>>& minimumDepths)
+    {
+        std::vector<bench::JsonObject> records;
+        for (const auto& r : runs)
+        {
+            bench::JsonObject record;
+            record.addString("profile", r.profile)
+                  .addNumber("depthSeconds", r.depthSeconds)
+                  .addCount("underruns", r.underruns)
+                  .addCount("underrunFrames", r.underrunFrames)
+                  .addNumber("minFillSeconds", r.minFillSeconds, 4)
+                  .addCount("stalls", r.stalls)
+                  .addCount("readErrors", r.readErrors)
+                  .addCount("failovers", r.failovers);
+            records.push_back(record);
+        }
+
+        // null = not even the deepest run got through
+        bench::JsonObject depths;
+        for (const auto& [name, depth] : minimumDepths)
+        {
+            if (depth > 0)
+                depths.addNumber(name, depth);
+            else
+                depths.addRaw(name, "null");
+        }
+
+        bench::JsonObject json;
+        json.addNumber("audioSeconds", options.audioSeconds)
+            .addNumber("timeScale", options.timeScale)
+            .addCount("channels", options.numChannels)
+            .addNumber("sampleRate", options.sampleRate)
+            .addArray("runs", records)
+            .addRaw("minimumDepthSeconds", depths.toString());
+        return bench::writeJsonFile(path, json);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    StressOptions options;
+    std::string jsonPath = "stress.json";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--quick")
+        {
+            options.audioSeconds = 30.0;
+            options.timeScale = 16.0;
+        }
+        else if (arg == "--profile" && i + 1 < argc)
+            options.onlyProfile = argv[++i];
+        else if (arg == "--json" && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+        {
+            std::cerr << "Usage: consoleAudioPlayerStress [--quick] [--profile NAME] [--json stress.json]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Underruns and failovers log at warning level - the table has the counts
+    auto& logger = RealtimeLogger::get();
+    logger.setMinimumLevel(RealtimeLogger::Level::error);
+    logger.start("stdout");
+
+    // Well above the loader's 10 ms tick, even sped up
+    const std::vector<double> depths = { 0.5, 1.0, 2.0, 3.0, 5.0, 8.0, 10.0 };
+
+    std::vector<RunResult> runs;
+    std::vector<std::pair<std::string, double>> minimumDepths;
+
+    for (const auto& profile : getProfiles())
+    {
+        if (!options.onlyProfile.empty() && profile.name != options.onlyProfile)
+            continue;
+
+        // The first depth without an underrun is the answer - deeper ones only take longer
+        double minimumDepth = 0.0;
+        for (double depth : depths)
+        {
+            auto result = runProfile(profile, depth, options);
+            printResult(result);
+            runs.push_back(result);
+
+            if (result.underruns == 0)
+            {
+                minimumDepth = depth;
+                break;
+            }
+        }
+
+        minimumDepths.emplace_back(profile.name, minimumDepth);
+    }
+
+    logger.stop();
+
+    std::cerr << std::endl << "Minimum buffer depth:" << std::endl;
+    for (const auto& [name, depth] : minimumDepths)
+    {
+        std::cerr << "  " << std::left << std::setw(14) << name;
+        if (depth > 0)
+            std::cerr << std::fixed << std::setprecision(1) << depth << " s" << std::endl;
+        else
+            std::cerr << "more than " << depths.back() << " s" << std::endl;
+    }
+
+    if (!writeJson(jsonPath, options, runs, minimumDepths))
+    {
+        std::cerr << "Error: cannot write " << jsonPath << std::endl;
+        return 1;
+    }
+
+    std::cerr << "Results written to " << jsonPath << std::endl;
+    return 0;
+}
@@ -0,0 +1,341 @@
+// Microbenchmarks for the player hot paths. Writes JSON (default benchmark.json)
+// so runs on the reference boxes can be compared across versions:
+//
+//   consoleAudioPlayerBench [--quick] [--json results.json]
+//
+// Test files are generated in the temp directory, so no assets are needed.
+
+#include "BenchSupport.h"
+#include "BufferedAudioFilePlayer.h"
+#include "RealtimeLogger.h"
+#include "choc/audio/choc_AudioFileFormat_WAV.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Result
+    {
+        std::string name;
+        bench::JsonObject parameters;  // e.g. { "blockSize": 64 }
+        uint64_t frames = 0;
+        double seconds = 0.0;
+        double sampleRate = 0.0;  // For the realtime factor; 0 = not audio-rate
+
+        double nsPerFrame() const { return frames ? seconds * 1e9 / frames : 0.0; }
+        double realtimeFactor() const { return seconds > 0 && sampleRate > 0 ? frames / sampleRate / seconds : 0.0; }
+    };
+
+    struct Benchmarks
+    {
+        double secondsPerCase = 0.25;
+        std::vector<Result> results;
+
+        void add(Result result)
+        {
+            std::cerr << std::left << std::setw(16) << result.name << std::setw(60) << result.parameters.toString()
+                      << std::right << std::fixed << std::setprecision(2) << std::setw(10) << result.nsPerFrame() << " ns/frame";
+            if (result.sampleRate > 0)
+                std::cerr << std::setprecision(0) << std::setw(10) << result.realtimeFactor() << "x realtime";
+            std::cerr << std::endl;
+            results.push_back(std::move(result));
+        }
+
+        bool writeJson(const std::string& path) const
+        {
+#if defined(__aarch64__)
+            const char* arch = "aarch64";
+#elif defined(__arm__)
+            const char* arch = "arm";
+#elif defined(__x86_64__)
+            const char* arch = "x86_64";
+#else
+            const char* arch = "unknown";
+#endif
+
+            std::vector<bench::JsonObject> records;
+            for (const auto& r : results)
+            {
+                bench::JsonObject record;
+                record.addString("name", r.name)
+                      .addFields(r.parameters)
+                      .addCount("frames", r.frames)
+                      .addNumber("seconds", r.seconds, 9)
+                      .addNumber("nsPerFrame", r.nsPerFrame(), 4)
+                      .addNumber("realtimeFactor", r.realtimeFactor(), 2);
+                records.push_back(record);
+            }
+
+            bench::JsonObject json;
+            json.addString("architecture", arch)
+                .addString("compiler", __VERSION__)
+                .addCount("timestamp", (uint64_t)std::chrono::duration_cast<std::chrono::seconds>(
+                                           std::chrono::system_clock::now().time_since_epoch()).count())
+                .addArray("results", records);
+            return bench::writeJsonFile(path, json);
+        }
+    };
+
+    double elapsedSeconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    const char* bitDepthName(choc::audio::BitDepth depth)
+    {
+        switch (depth)
+        {
+            case choc::audio::BitDepth::int16:   return "int16";
+            case choc::audio::BitDepth::int24:   return "int24";
+            case choc::audio::BitDepth::float32: return "float32";
+            default:                             return "other";
+        }
+    }
+
+    bool writeTestFile(const std::string& path, uint32_t numChannels, double sampleRate,
+                       choc::audio::BitDepth bitDepth, double seconds)
+    {
+        choc::audio::AudioFileProperties properties;
+        properties.formatName = "WAV";
+        properties.sampleRate = sampleRate;
+        properties.numChannels = numChannels;
+        properties.bitDepth = bitDepth;
+
+        auto stream = std::make_shared<std::ofstream>(path, std::ios::binary | std::ios::trunc);
+        choc::audio::WAVAudioFileFormat<true> format;
+        auto writer = format.createWriter(stream, properties);
+        if (!writer)
+            return false;
+
+        constexpr uint32_t chunk = 4096;
+        choc::buffer::ChannelArrayBuffer<float> buffer(choc::buffer::Size::create(numChannels, chunk));
+        bench::NoiseGenerator noise;
+
+        auto totalFrames = static_cast<uint64_t>(seconds * sampleRate);
+        for (uint64_t written = 0; written < totalFrames; written += chunk)
+        {
+            auto frames = static_cast<uint32_t>(std::min<uint64_t>(chunk, totalFrames - written));
+            noise.fill(buffer.getView().getStart(frames));
+
+            if (!writer->appendFrames(buffer.getView().getStart(frames)))
+                return false;
+        }
+
+        return writer->flush();
+    }
+
+    // fillBufferFromFile() via fillBuffer(): each round empties the FIFO with a
+    // seek and times one complete refill
+    void benchmarkFill(Benchmarks& bench, const std::string& path, uint32_t numChannels,
+                       double fileRate, double outputRate)
+    {
+        BufferedAudioFilePlayer player(path, outputRate);
+        if (!player.isLoaded())
+            return;
+        player.startPlayback(false);
+
+        Result result;
+        result.name = "fillBuffer";
+        result.parameters.addString("mode", fileRate == outputRate ? "direct" : "resampled")
+                         .addCount("channels", numChannels)
+                         .addCount("fileRate", (uint64_t)fileRate)
+                         .addCount("outputRate", (uint64_t)outputRate);
+        result.sampleRate = outputRate;
+
+        uint64_t position = 0;
+        while (result.seconds < bench.secondsPerCase)
+        {
+            player.seekToFrame(position);
+            auto start = Clock::now();
+            player.fillBuffer();
+            result.seconds += elapsedSeconds(start);
+
+            uint32_t filled = player.getBufferUsedSlots() / numChannels;
+            if (filled == 0)
+                break;
+            result.frames += filled;
+            position = (position + player.getTotalFrames() / 7) % player.getTotalFrames();
+        }
+
+        bench.add(result);
+    }
+
+    // processBlock() alone: the FIFO is refilled outside the timed region
+    void benchmarkProcessBlock(Benchmarks& bench, const std::string& path, uint32_t fileChannels,
+                               uint32_t outputChannels, uint32_t blockSize, double sampleRate)
+    {
+        BufferedAudioFilePlayer player(path, sampleRate);
+        if (!player.isLoaded())
+            return;
+        player.startPlayback(false);
+
+        choc::buffer::ChannelArrayBuffer<float> output(choc::buffer::Size::create(outputChannels, blockSize));
+        auto view = output.getView();
+
+        Result result;
+        result.name = "processBlock";
+        result.parameters.addCount("blockSize", blockSize)
+                         .addCount("channels", outputChannels)
+                         .addCount("fileChannels", fileChannels);
+        result.sampleRate = sampleRate;
+
+        while (result.seconds < bench.secondsPerCase)
+        {
+            player.fillBuffer();
+            uint32_t blocks = player.getBufferUsedSlots() / fileChannels / blockSize;
+            if (blocks == 0)
+                break;
+
+            auto start = Clock::now();
+            for (uint32_t i = 0; i < blocks; ++i)
+                player.processBlock(view);
+            result.seconds += elapsedSeconds(start);
+            result.frames += (uint64_t)blocks * blockSize;
+        }
+
+        bench.add(result);
+    }
+
+    // Same-thread push then pop of interleaved samples, as the loader and callback use it
+    void benchmarkFifo(Benchmarks& bench, uint32_t numChannels)
+    {
+        constexpr uint32_t capacityFrames = 16384;
+        choc::fifo::SingleReaderSingleWriterFIFO<float> fifo;
+        fifo.reset(capacityFrames * numChannels);
+
+        Result result;
+        result.name = "fifo";
+        result.parameters.addCount("channels", numChannels);
+
+        float sample = 0.0f, popped = 0.0f;
+        while (result.seconds < bench.secondsPerCase)
+        {
+            auto start = Clock::now();
+            for (uint32_t i = 0; i < capacityFrames * numChannels; ++i)
+                fifo.push(sample += 1.0f);
+            for (uint32_t i = 0; i < capacityFrames * numChannels; ++i)
+                fifo.pop(popped);
+            result.seconds += elapsedSeconds(start);
+            result.frames += capacityFrames;
+        }
+
+        bench.add(result);
+    }
+
+    // Raw choc WAV reader, 1024-frame chunks front to back
+    void benchmarkDecode(Benchmarks& bench, const std::string& path, uint32_t numChannels,
+                         choc::audio::BitDepth bitDepth, double sampleRate)
+    {
+        choc::audio::AudioFileFormatList formats;
+        formats.addFormat<choc::audio::WAVAudioFileFormat<false>>();
+        auto reader = formats.createReader(std::make_shared<std::ifstream>(path, std::ios::binary));
+        if (!reader)
+            return;
+
+        constexpr uint32_t chunk = 1024;
+        choc::buffer::ChannelArrayBuffer<float> buffer(choc::buffer::Size::create(numChannels, chunk));
+        uint64_t totalFrames = reader->getProperties().numFrames;
+
+        Result result;
+        result.name = "wavDecode";
+        result.parameters.addString("bitDepth", bitDepthName(bitDepth))
+                         .addCount("channels", numChannels);
+        result.sampleRate = sampleRate;
+
+        uint64_t position = 0;
+        while (result.seconds < bench.secondsPerCase)
+        {
+            auto start = Clock::now();
+            if (!reader->readFrames(position, buffer.getView()))
+                break;
+            result.seconds += elapsedSeconds(start);
+            result.frames += chunk;
+            position = (position + chunk + chunk <= totalFrames) ? position + chunk : 0;
+        }
+
+        bench.add(result);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Benchmarks bench;
+    std::string jsonPath = "benchmark.json";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--quick")
+            bench.secondsPerCase = 0.05;
+        else if (arg == "--json" && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+        {
+            std::cerr << "Usage: consoleAudioPlayerBench [--quick] [--json results.json]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Seeks log at info level - keep the table readable
+    auto& logger = RealtimeLogger::get();
+    logger.setMinimumLevel(RealtimeLogger::Level::warning);
+    logger.start("stdout");
+
+    // The player's own setup chatter goes to stdout; results go to stderr and the JSON file
+    auto directory = std::filesystem::temp_directory_path() / "consoleAudioPlayerBench";
+    std::filesystem::create_directories(directory);
+    auto testFile = [&] (uint32_t channels, double rate, choc::audio::BitDepth depth)
+    {
+        auto path = (directory / ("noise_" + std::to_string(channels) + "ch_" + std::to_string((int)rate)
+                                  + "_" + bitDepthName(depth) + ".wav")).string();
+        if (!std::filesystem::exists(path) && !writeTestFile(path, channels, rate, depth, 10.0))
+        {
+            std::cerr << "Error: cannot write test file " << path << std::endl;
+            std::exit(1);
+        }
+        return path;
+    };
+
+    const double rate = 48000.0;
+    const auto float32 = choc::audio::BitDepth::float32;
+
+    for (uint32_t channels : { 2u, 6u })
+    {
+        benchmarkFill(bench, testFile(channels, rate, float32), channels, rate, rate);
+        benchmarkFill(bench, testFile(channels, 44100.0, float32), channels, 44100.0, rate);
+    }
+
+    // Files with as many channels as the output, 16 included
+    for (uint32_t channels : { 1u, 2u, 4u, 8u, 16u })
+    {
+        auto path = testFile(channels, rate, float32);
+        for (uint32_t blockSize = 16; blockSize <= 1024; blockSize *= 2)
+            benchmarkProcessBlock(bench, path, channels, channels, blockSize, rate);
+    }
+
+    for (uint32_t channels : { 1u, 2u, 8u })
+        benchmarkFifo(bench, channels);
+
+    for (auto depth : { choc::audio::BitDepth::int16, choc::audio::BitDepth::int24, float32 })
+        benchmarkDecode(bench, testFile(2, rate, depth), 2, depth, rate);
+
+    logger.stop();
+
+    if (!bench.writeJson(jsonPath))
+    {
+        std::cerr << "Error: cannot write " << jsonPath << std::endl;
+        return 1;
+    }
+
+    std::cerr << "Results written to " << jsonPath << std::endl;
+    return 0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "AudioBackend.h"
+#include <alsa/asoundlib.h>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+// Plays straight into an ALSA PCM (e.g. "hw:0"), for appliances where the
+// player is the only audio client and the JACK server is an extra context
+// switch and period of latency. Its own thread renders one period at a time
+// and converts it straight into the mmap'd DMA buffer in the device's native
+// format (S32_LE, S24_3LE or S16_LE) - no interleaved staging buffer and no
+// write() copy. The buffer is a whole number of periods, so each period lands
+// in one contiguous mmap_begin/commit.
+class AlsaBackend : public AudioBackend
+{
+public:
+    AlsaBackend() = default;
+    ~AlsaBackend() override;
+
+    const char* getName() const override { return "alsa"; }
+
+    bool open(const Options& options) override;
+    bool start(ProcessCallback callback) override;
+    void stop() override;
+
+    double getSampleRate() const override { return sampleRate; }
+    uint32_t getBlockSize() const override { return periodFrames; }
+
+    uint64_t getXrunCount() const override { return xruns.load(std::memory_order_relaxed); }
+    uint32_t getOutputLatency() const override { return bufferFrames - periodFrames; }
+    int getRealtimePriority() const override { return realtimePriority; }  // What the thread got, after start()
+
+private:
+    static constexpr int threadPriority = 80;  // Same class of thread JACK would give us
+    int realtimePriority = 0;
+
+    snd_pcm_t* pcm = nullptr;
+    snd_pcm_format_t format = SND_PCM_FORMAT_S32_LE;
+    std::string deviceName;
+    double sampleRate = 0.0;
+    uint32_t periodFrames = 0;
+    uint32_t bufferFrames = 0;
+    uint32_t numChannels = 0;
+
+    std::vector<std::vector<float>> channelData;
+    std::vector<float*> channelPointers;
+
+    ProcessCallback processCallback;
+    std::thread processThread;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> xruns{0};
+
+    bool configure(const Options& options);
+    void run(std::promise<int>& scheduled);
+    int writePeriod();
+    void convertToArea(const snd_pcm_channel_area_t* areas, snd_pcm_uframes_t offset,
+                       uint32_t sourceFrame, uint32_t numFrames);
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "choc/audio/choc_AudioSampleData.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+// One incoming MIDI message, timestamped within the block
+struct MidiInputEvent
+{
+    uint32_t frame = 0;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+// Everything the process callback gets for one period
+struct AudioProcessBlock
+{
+    uint32_t numFrames = 0;
+    choc::buffer::ChannelArrayView<float> output;  // Cleared or stale - the callback overwrites every frame
+
+    float* ltcOutput = nullptr;                    // Mono timecode signal, if the backend has somewhere to put it
+    const MidiInputEvent* midiEvents = nullptr;    // In time order
+    uint32_t numMidiEvents = 0;
+    void* midiOutput = nullptr;                    // JACK MIDI buffer for MTC / clock, if available
+};
+
+// Where the audio goes: the JACK server, an ALSA device directly, or nowhere
+// (null backend, paced by a timer - for load tests on machines without sound
+// hardware). The process callback runs on the backend's realtime thread.
+class AudioBackend
+{
+public:
+    using ProcessCallback = std::function<void(AudioProcessBlock&)>;
+
+    struct Options
+    {
+        std::string clientName = "consoleAudioPlayer";
+        std::string device;            // ALSA PCM name; ignored by JACK / null
+        double sampleRate = 48000.0;   // Requested - JACK uses the server's rate
+        uint32_t blockSize = 64;       // Requested - JACK uses the server's period
+        uint32_t numOutputChannels = 2;
+        bool midiInput = false;
+        bool midiOutput = false;
+        bool ltcOutput = false;
+    };
+
+    virtual ~AudioBackend() = default;
+
+    // "jack", "alsa" or "null"; nullptr for anything else
+    static std::unique_ptr<AudioBackend> create(const std::string& name);
+
+    virtual const char* getName() const = 0;
+
+    // Open the device / client and set up ports, without starting processing
+    virtual bool open(const Options& options) = 0;
+
+    // Start calling 'callback' on the realtime thread / stop it again
+    virtual bool start(ProcessCallback callback) = 0;
+    virtual void stop() = 0;
+
+    virtual double getSampleRate() const = 0;
+    virtual uint32_t getBlockSize() const = 0;
+    std::string getErrorMessage() const { return errorMessage; }
+
+    // What open() actually managed to provide
+    virtual bool hasMidiInput() const { return false; }
+    virtual bool hasMidiOutput() const { return false; }
+    virtual bool hasLtcOutput() const { return false; }
+
+    // Telemetry; negative load = the backend can't measure it
+    virtual uint64_t getXrunCount() const = 0;
+    virtual double getCpuLoad() const { return -1.0; }
+
+    // Frames between the callback writing a sample and it reaching the output jack
+    virtual uint32_t getOutputLatency() const { return 0; }
+
+    // SCHED_FIFO priority of the audio thread, 0 if it isn't realtime
+    virtual int getRealtimePriority() const { return 0; }
+
+    // Transport hooks - only JACK has a shared transport, the others ignore them
+    virtual void transportStart() {}
+    virtual void transportStop() {}
+    virtual void transportLocate(uint64_t frame) {}
+
+    // Position to publish as transport master, asked for once per cycle (realtime thread)
+    virtual void setTimebaseSource(std::function<uint64_t()> frameSource) {}
+
+    // Called when the period size changes after start() (set before start())
+    void setBlockSizeCallback(std::function<void(uint32_t)> callback) { onBlockSizeChanged = std::move(callback); }
+
+    // Called from the audio thread when the device fails for good and processing has
+    // stopped; getErrorMessage() says why once hasFailed() (set before start())
+    void setFailureCallback(std::function<void()> callback) { onFailure = std::move(callback); }
+    bool hasFailed() const { return failed.load(std::memory_order_acquire); }
+
+protected:
+    std::string errorMessage;
+    std::function<void(uint32_t)> onBlockSizeChanged;
+
+    void reportFailure(std::string message)
+    {
+        errorMessage = std::move(message);
+        failed.store(true, std::memory_order_release);
+        if (onFailure) onFailure();
+    }
+
+private:
+    std::atomic<bool> failed{false};
+    std::function<void()> onFailure;
+};
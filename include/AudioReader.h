@@ -0,0 +1,151 @@
+#pragma once
+
+#include "choc/audio/choc_AudioFileFormat.h"
+#include "choc/audio/choc_AudioSampleData.h"
+#include "IoUringStreamBuf.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+
+// Where the player's loader gets its frames from. The player normally reads
+// the audio file (FileAudioReader); the others stand in for it so benchmarks
+// and stress runs can play from RAM, or from simulated slow or failing storage.
+// Called from the loader thread only (or the thread driving fillBuffer()).
+class AudioReader
+{
+public:
+    virtual ~AudioReader() = default;
+
+    virtual const choc::audio::AudioFileProperties& getProperties() const = 0;
+
+    // Reads dest.getNumFrames() frames from 'frame' (file sample rate, within the file)
+    virtual bool readFrames(uint64_t frame, const choc::buffer::ChannelArrayView<float>& dest) = 0;
+
+    // Switches to a copy of the same audio at 'path', for failover. False (see
+    // getErrorMessage) if it can't be opened or isn't the same audio.
+    virtual bool reopen(const std::string&) { errorMessage = "Reader has no file to reopen"; return false; }
+
+    // The file being read; empty if there isn't one
+    virtual std::string getPath() const { return {}; }
+
+    // The read-ahead under the decoder - for telemetry and chunk sizing. nullptr if there isn't one.
+    virtual const IoUringStreamBuf* getReadAhead() const { return nullptr; }
+
+    std::string getErrorMessage() const { return errorMessage; }
+
+    // As stored in the file, for throughput figures
+    static uint32_t getBytesPerFrame(const choc::audio::AudioFileProperties& properties);
+
+protected:
+    std::string errorMessage;
+};
+
+// The audio file through the io_uring read-ahead and choc's WAV decoder
+class FileAudioReader : public AudioReader
+{
+public:
+    bool open(const std::string& path, const IoUringStreamBuf::Options& options);
+
+    const choc::audio::AudioFileProperties& getProperties() const override { return properties; }
+    bool readFrames(uint64_t frame, const choc::buffer::ChannelArrayView<float>& dest) override;
+    bool reopen(const std::string& path) override;
+    std::string getPath() const override { return path; }
+    const IoUringStreamBuf* getReadAhead() const override { return stream ? &stream->getBuffer() : nullptr; }
+
+private:
+    std::string path;
+    std::shared_ptr<IoUringFileStream> stream;
+    std::unique_ptr<choc::audio::AudioFileReader> decoder;
+    choc::audio::AudioFileProperties properties;
+
+    std::unique_ptr<choc::audio::AudioFileReader> createDecoder();
+};
+
+// Audio already in RAM - no storage in the way at all. Any path "reopens" the
+// same frames, so failover can be exercised without files.
+class MemoryAudioReader : public AudioReader
+{
+public:
+    MemoryAudioReader(choc::buffer::ChannelArrayBuffer<float> frames, double sampleRate);
+
+    const choc::audio::AudioFileProperties& getProperties() const override { return properties; }
+    bool readFrames(uint64_t frame, const choc::buffer::ChannelArrayView<float>& dest) override;
+    bool reopen(const std::string&) override { return true; }
+
+private:
+    choc::buffer::ChannelArrayBuffer<float> frames;
+    choc::audio::AudioFileProperties properties;
+};
+
+// Base for readers that wrap another and change how it behaves
+class AudioReaderDecorator : public AudioReader
+{
+public:
+    explicit AudioReaderDecorator(std::unique_ptr<AudioReader> inner) : inner(std::move(inner)) {}
+
+    const choc::audio::AudioFileProperties& getProperties() const override { return inner->getProperties(); }
+    bool readFrames(uint64_t frame, const choc::buffer::ChannelArrayView<float>& dest) override { return inner->readFrames(frame, dest); }
+    bool reopen(const std::string& path) override;
+    std::string getPath() const override { return inner->getPath(); }
+    const IoUringStreamBuf* getReadAhead() const override { return inner->getReadAhead(); }
+
+protected:
+    std::unique_ptr<AudioReader> inner;
+};
+
+// Storage with a fixed throughput: each read takes its bytes / bytesPerSecond,
+// plus a per-read access time, and reads queue behind each other like they
+// would on one device. 'timeScale' speeds the simulated device up together
+// with a driver that plays faster than real time.
+class ThrottledAudioReader : public AudioReaderDecorator
+{
+public:
+    ThrottledAudioReader(std::unique_ptr<AudioReader> inner, double bytesPerSecond,
+                         double accessSeconds = 0.0, double timeScale = 1.0);
+
+    bool readFrames(uint64_t frame, const choc::buffer::ChannelArrayView<float>& dest) override;
+
+private:
+    double bytesPerSecond;
+    double accessSeconds;
+    double timeScale;
+    std::chrono::steady_clock::time_point busyUntil;
+};
+
+// Storage that misbehaves: random stalls (SD card garbage collection, a
+// spun-down disk), random failed reads, and media that dies outright at a
+// given frame until the reader is reopened. Seeded, so the same options
+// give the same sequence of faults.
+class FaultInjectingAudioReader : public AudioReaderDecorator
+{
+public:
+    struct Options
+    {
+        double stallProbability = 0.0;   // Per read
+        double stallSeconds = 0.0;       // Stalls last up to this long (uniform)
+        double errorProbability = 0.0;   // Per read
+        uint64_t failFromFrame = UINT64_MAX;  // Once a read reaches it, every read fails until reopen()
+        double timeScale = 1.0;          // As for ThrottledAudioReader
+        uint32_t seed = 1;
+    };
+
+    FaultInjectingAudioReader(std::unique_ptr<AudioReader> inner, const Options& options);
+
+    bool readFrames(uint64_t frame, const choc::buffer::ChannelArrayView<float>& dest) override;
+    bool reopen(const std::string& path) override;
+
+    uint64_t getStalls() const { return stalls.load(std::memory_order_relaxed); }
+    uint64_t getErrors() const { return errors.load(std::memory_order_relaxed); }
+
+private:
+    Options options;
+    bool mediaFailed = false;
+    std::minstd_rand random;
+    std::uniform_real_distribution<double> uniform{0.0, 1.0};
+
+    std::atomic<uint64_t> stalls{0};
+    std::atomic<uint64_t> errors{0};
+};
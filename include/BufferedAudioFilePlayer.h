@@ -1,19 +1,29 @@
 #pragma once
 
-#include "choc/audio/choc_AudioFileFormat.h"
 #include "choc/audio/choc_AudioSampleData.h"
 #include "choc/containers/choc_SingleReaderSingleWriterFIFO.h"
 #include "choc/threading/choc_TaskThread.h"
+#include "AudioReader.h"
+#include "LatencyHistogram.h"
 #include <string>
+#include <vector>
 #include <memory>
 #include <atomic>
+#include <functional>
+#include <chrono>
 
 // Simple buffered audio file player using CHOC's FIFO for low-memory systems
 // Keeps a small ring buffer (few seconds) filled by background thread
 class BufferedAudioFilePlayer
 {
 public:
-    BufferedAudioFilePlayer(const std::string& filePath, double outputSampleRate = 48000.0);
+    // An output rate of 0 plays at the file's own rate (until setOutputSampleRate()).
+    // 'readOptions' set up the read-ahead under the decoder (io_uring, O_DIRECT, block size).
+    BufferedAudioFilePlayer(const std::string& filePath, double outputSampleRate = 48000.0,
+                            const IoUringStreamBuf::Options& readOptions = {});
+
+    // Plays from any reader - in-memory audio, or simulated storage for stress runs
+    BufferedAudioFilePlayer(std::unique_ptr<AudioReader> reader, double outputSampleRate = 48000.0);
     ~BufferedAudioFilePlayer();
 
     void setOutputSampleRate(double rate);
@@ -25,71 +35,259 @@ public:
     bool isStillPlaying() const { return isPlaying; }
     std::string getErrorMessage() const { return errorMessage; }
 
-    void startPlayback(); // Call this before adding to audio player
+    // Call this before adding to audio player. Buffers 'prefillSeconds' (negative = 90%
+    // of the ring) before returning; the loader thread tops up the rest in the background.
+    void startPlayback(bool useLoaderThread = true, double prefillSeconds = -1.0);
+
+    // Stops the loader thread for good, so none of its callbacks run after this returns
+    void stopLoading();
+
+    // Reads on the calling thread until 'seconds' of audio is buffered (negative = 90%
+    // of the ring). Before startPlayback() only - lets startup overlap it with other work.
+    void prefill(double seconds);
+
+    // Without the loader thread (offline rendering), the caller tops the FIFO up
+    // between blocks - single-threaded, so the output is deterministic. A pending seek
+    // is applied once processBlock() has faded out and parked, as with the loader.
+    void fillBuffer();
 
-    // Playback control
+    // Playback control. Both take effect at the next processBlock() - called between
+    // sub-blocks, on the exact sample - and ramp the output over 5 ms rather than cut.
     void play() { isPlaying = true; }
-    void pause() { isPlaying = false; }
-    void stop() { isPlaying = false; fileReadPosition = 0; totalSamplesPlayed = 0; audioBuffer.reset(bufferSize); }
-    uint64_t skipForward(double seconds);  // Returns new position (for JACK sync)
+    void pause() { isPlaying = false; seekRequestedAt.store(0, std::memory_order_relaxed); }
+    void stop() { isPlaying = false; requestSeek(0, false); }
+
+    // Seeks never block: the loader thread empties the FIFO and refills from the new
+    // position ahead of normal streaming, and the callback outputs silence until it has.
+    // Absolute, in file sample rate. Returns the new output position. 'timed': the time
+    // until the first frame from there is played goes into Stats::seekLatency.
+    uint64_t seekToFrame(uint64_t fileFrame, bool timed = false);
+    bool isSeekPending() const { return seekRequested.load(std::memory_order_acquire) != seekApplied.load(std::memory_order_acquire); }
+
+    // 'seconds' (negative = backwards) from the audible frame, wrapped into the file
+    uint64_t getRelativeSeekTarget(double seconds, uint32_t outputLatencyFrames) const;
 
     // Volume control (0.0 to 1.0)
     void setGain(float gain) { currentGain.store(std::clamp(gain, 0.0f, 1.0f), std::memory_order_relaxed); }
     float getGain() const { return currentGain.load(std::memory_order_relaxed); }
 
     // For monitoring buffer health
-    uint32_t getBufferUsedSlots() const { return audioBuffer.getUsedSlots(); }
-    uint32_t getBufferSize() const { return bufferSize; }
+    uint32_t getBufferUsedSlots() const;
+    uint32_t getBufferSize() const { return bufferSize.load(std::memory_order_relaxed); }  // Allocated now
+
+    // The loader keeps the FIFO filled to a depth between these, sized to ride out
+    // the slowest reads it has seen. The FIFO follows the depth: the loader allocates
+    // one of the new size, the callback moves over to it once the old one has played
+    // out, and the loader frees the old one - neither end of a resize touches the
+    // audio. Call before prefaultBuffers() / prefill() - it empties the buffer.
+    // Equal = fixed depth.
+    void setBufferLimits(double minSeconds, double maxSeconds);
+    uint32_t getBufferDepth() const { return bufferDepth.load(std::memory_order_relaxed); }  // Samples
+    double getBufferDepthSeconds() const { return (double)getBufferDepth() / numChannels / outputSampleRate; }
+
+    // Telemetry - lock-free counters updated from the audio and loader threads
+    struct Stats
+    {
+        std::atomic<uint64_t> underruns{0};         // Blocks short of data, partly or wholly silent
+        std::atomic<uint64_t> underrunFrames{0};    // The silent frames alone
+        std::atomic<uint64_t> fillSampleSum{0};     // FIFO fill seen by each processBlock()
+        std::atomic<uint64_t> fillObservations{0};
+        std::atomic<uint32_t> minFillSamples{UINT32_MAX};  // Lowest fill since takeMinBufferFill()
+        std::atomic<uint64_t> bytesRead{0};
+        std::atomic<uint64_t> framesRead{0};
+        std::atomic<uint64_t> readErrors{0};
+        std::atomic<uint64_t> loops{0};
+        std::atomic<uint64_t> seeks{0};             // Applied by the loader
+        std::atomic<uint64_t> failovers{0};         // Switches to another source after a read failure
+        std::atomic<uint32_t> activeSource{0};      // 0 = the audio file, then the replicas in order
+        LatencyHistogram refillLatency;             // Read + convert + push, per chunk
+        LatencyHistogram seekLatency;               // Timed seek request to its first frame played
+    };
+
+    const Stats& getStats() const { return stats; }
+    const IoUringStreamBuf* getReadAhead() const { return reader ? reader->getReadAhead() : nullptr; }  // nullptr = not reading a file
+    uint32_t takeMinBufferFill() { return stats.minFillSamples.exchange(UINT32_MAX, std::memory_order_relaxed); }
 
     // For loop detection
     std::atomic<bool> getLoopPlaybackDetected() { return loopPlaybackDetected.exchange(false); }
 
+    // Called from the loader thread whenever the file wraps (set before startPlayback())
+    void setLoopCallback(std::function<void()> callback) { onLoopDetected = std::move(callback); }
+
+    // Called once from the loader thread when the FIFO next holds 'seconds' of audio
+    // (capped at 90% of the ring) after armBufferedNotification(). Set before startPlayback().
+    void setBufferedCallback(std::function<void()> callback) { onBuffered = std::move(callback); }
+    void armBufferedNotification(double seconds) { bufferedThreshold.store(getFillTarget(seconds), std::memory_order_release); }
+    bool isBuffered(double seconds) const { return !isSeekPending() && getBufferUsedSlots() >= getFillTarget(seconds); }
+
+    // Runs once on the loader thread before its first read - affinity, priority
+    // and stack prefaulting (set before startPlayback())
+    void setLoaderThreadInit(std::function<void()> callback) { onLoaderThreadStart = std::move(callback); }
+
+    // Frames decoded per loader read (0 = about one read-ahead block's worth, the
+    // default, or 4096 without a file). Clamped to 1024-16384. Set before startPlayback().
+    void setChunkFrames(uint32_t frames);
+    uint32_t getChunkFrames() const { return chunkFrames; }
+
+    // Copies of the audio file on other media. When a read fails (I/O error, the disk
+    // or share gone), the loader reopens the next one and carries on from the same
+    // frame while the callback plays out the FIFO. Set before startPlayback().
+    void setReplicaPaths(const std::vector<std::string>& paths);
+
+    // Touches every page of the FIFO and the loader's decode buffer so the first
+    // pass through them doesn't page-fault (FIFOs allocated later by a resize are
+    // touched by the loader before the callback gets them). Call after setChunkFrames() and before
+    // startPlayback() - it empties the buffer.
+    void prefaultBuffers();
+
     // Get current playback position in output sample rate (for JACK Transport)
     uint64_t getCurrentOutputFrame() const {
         // Return actual playback position (samples sent to speakers)
         return totalSamplesPlayed.load(std::memory_order_relaxed);
     }
 
+    // File frame the next output sample comes from. Tracked through the FIFO, so it's
+    // what the callback is emitting rather than how far ahead the loader has read.
+    uint64_t getEmittedFileFrame() const { return emittedFileFrame.load(std::memory_order_acquire); }
+    uint64_t getEmittedOutputFrame() const { return (uint64_t)(getEmittedFileFrame() * outputSampleRate / fileSampleRate); }
+
+    // File frame leaving the speakers now, given the backend's output latency
+    // (AudioBackend::getOutputLatency). While paused: the last one played; while a
+    // seek is pending: its target.
+    uint64_t getAudibleFileFrame(uint32_t outputLatencyFrames) const;
+
     // File info (for JACK Transport sync)
     uint64_t getTotalFrames() const { return totalFrames; }
     double getFileSampleRate() const { return fileSampleRate; }
     double getOutputSampleRate() const { return outputSampleRate; }
 
 private:
-    std::string filePath;
-    std::shared_ptr<std::ifstream> fileStream;
-    std::unique_ptr<choc::audio::AudioFileReader> fileReader;
+    std::unique_ptr<AudioReader> reader;
+
+    // Failover (loader thread): the audio file first, then its replicas
+    std::vector<std::string> sourcePaths;
+    uint32_t activeSource = 0;
+    bool sourceFailed = false;
+    std::chrono::steady_clock::time_point nextFailoverAttempt;
+    static constexpr std::chrono::milliseconds failoverRetryInterval{500};
 
     double fileSampleRate = 0.0;
     double outputSampleRate = 48000.0;
     uint32_t numChannels = 0;
     uint64_t totalFrames = 0;
+    uint32_t bytesPerFileFrame = 0;  // On disk, for the bytes-read counter
 
     std::atomic<bool> isPlaying{true};
     std::atomic<bool> fileLoaded{false};
     std::atomic<float> currentGain{1.0f};  // Volume: 0.0 = silence, 1.0 = full
     std::string errorMessage;
 
-    // Simple interleaved FIFO buffer
-    choc::fifo::SingleReaderSingleWriterFIFO<float> audioBuffer;
-    static constexpr uint32_t bufferSizeSeconds = 3; // Keep 3 seconds buffered
-    uint32_t bufferSize = 0; // Will be calculated based on sample rate
+    // Interleaved FIFO. The loader owns both allocations: it pushes into fillingBuffer,
+    // and after a resize keeps the previous one in drainingBuffer until the callback
+    // has moved off it (readBuffer). Only one resize is in flight at a time.
+    using SampleFifo = choc::fifo::SingleReaderSingleWriterFIFO<float>;
+    std::unique_ptr<SampleFifo> fillingBuffer;
+    std::unique_ptr<SampleFifo> drainingBuffer;
+    std::atomic<SampleFifo*> writeBuffer{nullptr};  // fillingBuffer, published to the callback
+    std::atomic<SampleFifo*> readBuffer{nullptr};   // Popped by the callback
+    static constexpr double defaultBufferSeconds = 3.0; // Starting depth, within the limits
+    double bufferMinSeconds = defaultBufferSeconds;
+    double bufferMaxSeconds = defaultBufferSeconds;
+    std::atomic<uint32_t> bufferSize{0};   // fillingBuffer's capacity, in samples
+    std::atomic<uint32_t> bufferDepth{0};  // Samples the loader fills up to
+    static constexpr uint32_t bufferShrinkRatio = 2;  // Reallocated smaller once the depth is under half of it
+
+    // Fill level for the other threads, across both FIFOs: samples ever pushed less
+    // samples ever popped. Each side only stores its own count.
+    std::atomic<uint64_t> samplesPushed{0};
+    std::atomic<uint64_t> samplesPopped{0};
+    uint64_t pushedCount = 0;  // Loader thread only
+    uint64_t poppedCount = 0;  // Audio thread only
+    std::vector<float> frameScratch;  // Audio thread only - one interleaved frame, any channel count
+
+    // Depth adaptation (loader thread): enough for the worst recent read, several times over
+    static constexpr double stallMarginFactor = 4.0;
+    static constexpr double depthHeadroomSeconds = 0.5;
+    static constexpr uint64_t depthWindowReads = 2048;  // ~45 s at 48 kHz - long enough for a p99.9
+    LatencyHistogram readWindow;
 
     // File reading state
     std::atomic<uint64_t> fileReadPosition{0};
+    static constexpr uint32_t minChunkFrames = 1024, maxChunkFrames = 16384, defaultChunkFrames = 4096;
+    uint32_t chunkFrames = minChunkFrames;
+    choc::buffer::ChannelArrayBuffer<float> decodeBuffer;  // Loader thread only
 
     // Playback position tracking (actual samples sent to output)
     std::atomic<uint64_t> totalSamplesPlayed{0};
 
+    // Position map: the loader tags each chunk it pushes with where it came from
+    // in the file, and the callback consumes tags as it pops frames
+    struct PositionTag
+    {
+        uint64_t fileFrame = 0;               // Source of the chunk's first frame
+        uint32_t outputFrames = 0;            // Frames it occupies in the FIFO
+        double fileFramesPerOutputFrame = 1.0;
+    };
+
+    choc::fifo::SingleReaderSingleWriterFIFO<PositionTag> positionTags;
+    uint32_t positionTagCapacity = 0;
+    std::atomic<uint64_t> emittedFileFrame{0};
+    std::atomic<bool> positionMapReset{false};  // Tags were dropped - the callback forgets its current one
+    PositionTag currentTag;                      // Audio thread only
+    uint32_t currentTagFramesUsed = 0;           // Audio thread only
+
+    // Seek handoff. The control thread posts a target and bumps seekRequested; the
+    // callback stops reading the FIFO and acknowledges in seekParked; then the loader
+    // - the only thread that may reset the FIFO - refills and publishes seekApplied.
+    std::atomic<uint64_t> seekTarget{0};
+    std::atomic<uint64_t> seekRequestedAt{0};  // steady_clock ns of a timed seek, 0 = not timed
+    std::atomic<uint32_t> seekRequested{0};
+    std::atomic<uint32_t> seekParked{0};
+    std::atomic<uint32_t> seekApplied{0};
+    bool seekAwaitingAudio = false;  // Audio thread only - the next block played closes a timed seek
+    static constexpr double seekRefillSeconds = 0.05;  // Buffered before the callback may resume
+    static constexpr int seekParkTimeoutMs = 20;       // No callback running - retry on the next tick
+
     // Background loading
     choc::threading::TaskThread backgroundThread;
     std::atomic<bool> shouldStopLoading{false};
+    std::function<void()> onLoaderThreadStart;
+    bool loaderThreadStarted = false;  // Loader thread only
+
+    bool inUnderrun = false;  // Audio thread only - underruns are logged once per episode
+    float transportGain = 0.0f;  // Audio thread only - ramps to 1 on play() and to 0 on pause()
+    float transportRampStep = 0.0f;
+    static constexpr double transportRampSeconds = 0.005;
+    static constexpr uint32_t concealFadeFrames = 64;  // Fade out into an underrun, and in after it
 
     // Loop detection
     std::atomic<bool> loopPlaybackDetected{false};
+    std::function<void()> onLoopDetected;
+
+    // Buffered notification - 0 = not armed
+    std::atomic<uint32_t> bufferedThreshold{0};
+    std::function<void()> onBuffered;
+
+    Stats stats;
 
+    void initialise();
     bool loadAudioFile();
+    bool failOver(uint64_t resumeFrame);
     void backgroundLoadingTask();
     void fillBufferFromFile();
-    uint32_t getBufferSizeForSampleRate(double sampleRate) const;
+    void recordRead(uint64_t fileFrames, std::chrono::steady_clock::time_point started);
+    void allocateBuffer();
+    void resizeBuffer();
+    void emptyBuffer();
+    bool pushSample(float sample);
+    static void prefaultFifo(SampleFifo& fifo, uint32_t capacity);
+    void adaptBufferDepth(uint64_t readNanoseconds);
+    uint32_t getDepthForStall(uint64_t readNanoseconds) const;
+    void printResampling() const;
+    choc::buffer::ChannelArrayView<float> getDecodeView(uint32_t frames);
+    void requestSeek(uint64_t fileFrame, bool timed);
+    bool applyPendingSeek(bool waitForCallback);
+    void resetPositionMap(uint64_t fileFrame);
+    void advancePositionMap(uint32_t numFrames);
+    uint32_t getFillTarget(double seconds) const;
 };
\ No newline at end of file
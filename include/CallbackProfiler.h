@@ -0,0 +1,77 @@
+#pragma once
+
+#include "LatencyHistogram.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <time.h>
+
+// Times each stage of the process callback and compares the whole cycle with
+// the period budget (buffer size / sample rate). Stamps come from the vDSO
+// CLOCK_MONOTONIC_RAW (no syscall, not slewed by NTP), a handful per cycle,
+// and go into lock-free histograms - so it stays on in production and a
+// small-block deployment can be tuned from real numbers.
+class CallbackProfiler
+{
+public:
+    enum Stage
+    {
+        midiStage,      // Reading and dispatching MIDI input
+        renderStage,    // processBlock() sub-blocks
+        timecodeStage,  // LTC / MTC / clock output
+        positionStage,  // Caching the play position for the timebase callback
+        numStages
+    };
+
+    static uint64_t now()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    // Lives on the callback's stack: lap() charges the time since the previous
+    // lap to a stage, so stages can interleave (render, midi, render, ...)
+    struct Cycle
+    {
+        uint64_t start = now();
+        uint64_t mark = start;
+        uint64_t stageNs[numStages] = {};
+
+        void lap(Stage stage)
+        {
+            uint64_t t = now();
+            stageNs[stage] += t - mark;
+            mark = t;
+        }
+    };
+
+    // Any thread (JACK buffer size callback); 0 frames = no budget known
+    void setBudget(uint32_t periodFrames, double sampleRate);
+
+    // Process callback - the only writer
+    void record(const Cycle& cycle);
+
+    // Control / metrics threads
+    double getBudgetSeconds() const { return budgetNs.load(std::memory_order_relaxed) * 1e-9; }
+    uint64_t getOverBudgetCount() const { return overBudget.load(std::memory_order_relaxed); }
+    const LatencyHistogram& getCycleHistogram() const { return cycleTime; }
+    const LatencyHistogram& getStageHistogram(Stage stage) const { return stageTime[stage]; }
+
+    void writePrometheus(std::string& out) const;
+    std::string getReport() const;
+
+    static const char* stageName(Stage stage);
+
+private:
+    LatencyHistogram cycleTime;
+    LatencyHistogram stageTime[numStages];  // Only cycles where the stage ran
+
+    std::atomic<uint64_t> budgetNs{0};
+    std::atomic<uint32_t> periodFrames{0};
+    std::atomic<uint64_t> overBudget{0};
+
+    // The slowest cycle so far and the stage that took most of it
+    std::atomic<uint64_t> worstCycleNs{0};
+    std::atomic<int> worstCycleStage{renderStage};
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+// inotify watch on the config file, for the control thread's reactor. Watches
+// the directory rather than the file itself, so editors that save by writing a
+// temporary file and renaming it over the original are still noticed.
+class ConfigWatcher
+{
+public:
+    ConfigWatcher() = default;
+    ~ConfigWatcher();
+
+    bool start(const std::string& filePath);
+
+    // Readable when something happened in the directory (for ControlReactor::onReadable)
+    int getFd() const { return inotifyFd; }
+
+    // Drains pending events. True if any of them finished writing the watched file.
+    bool readChanges();
+
+    std::string getErrorMessage() const { return errorMessage; }
+
+private:
+    int inotifyFd = -1;
+    std::string fileName;
+    std::string errorMessage;
+};
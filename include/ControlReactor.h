@@ -0,0 +1,69 @@
+#pragma once
+
+#include <signal.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Single-threaded epoll event loop for the control (main) thread. Replaces the
+// 1 ms polling loop: the thread sleeps in epoll_wait until there's actually
+// something to do - a key press, a notification from the audio or loader
+// thread (eventfd), a timer (timerfd) or a signal (signalfd).
+class ControlReactor
+{
+public:
+    using Handler = std::function<void()>;
+
+    ControlReactor();
+    ~ControlReactor();
+
+    bool isValid() const { return epollFd >= 0; }
+
+    // eventfd other threads can poke with notify(). Owned by the reactor.
+    int createNotifier();
+
+    // One-shot or periodic timerfd, armed with armTimer(). Owned by the reactor.
+    int createTimer();
+    void armTimer(int timerFd, uint32_t delayMs, uint32_t intervalMs = 0);
+    void disarmTimer(int timerFd) { armTimer(timerFd, 0, 0); }
+
+    // signalfd for the given signals. They must already be blocked in every thread
+    // (block them at the top of main(), before any threads are started).
+    int createSignalFd(const sigset_t& signals, std::function<void(int)> handler);
+
+    // Call 'handler' whenever 'fd' becomes readable. Notifier and timer counters are
+    // drained before the handler runs; for other fds the handler does the reading.
+    bool onReadable(int fd, Handler handler);
+
+    // Stop watching 'fd' (closing it if the reactor owns it) - e.g. a pipe that hit
+    // EOF, which would otherwise stay readable forever. Safe from inside a handler.
+    void remove(int fd);
+
+    // Wake the reactor. Safe from the realtime thread: one non-blocking write, no locks.
+    static void notify(int notifierFd);
+
+    void run();  // Dispatches until stop()
+    void stop() { running = false; }
+
+private:
+    enum class SourceKind { readable, notifier, timer, signal };
+
+    struct Source
+    {
+        int fd = -1;
+        SourceKind kind = SourceKind::readable;
+        bool owned = false;
+        Handler handler;
+        std::function<void(int)> signalHandler;
+        bool removed = false;  // Erased after the current batch of events
+    };
+
+    int epollFd = -1;
+    bool running = false;
+    std::vector<std::unique_ptr<Source>> sources;
+
+    Source* findSource(int fd) const;
+    Source* addSource(int fd, SourceKind kind, bool owned);
+    void eraseRemovedSources();
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// Read-ahead for the audio file, underneath the WAV decoder's istream. The file
+// is read in large aligned blocks (optionally O_DIRECT), and several of them
+// are kept in flight on an io_uring ahead of the read position - wrapping round
+// to the start near the end, since the player loops. The decoder then copies
+// out of memory that's usually already there, so storage latency hides behind
+// the FIFO and there's one syscall per block instead of one per chunk.
+// The ring is driven with raw syscalls (no liburing). Where io_uring isn't
+// available (old kernel, seccomp), the same blocks are read with pread().
+// Without O_DIRECT the page cache is steered too: SEQUENTIAL for the file,
+// WILLNEED for the block past the in-flight window, and (dropBehind) DONTNEED
+// for blocks already copied out, so audio that's been played doesn't crowd
+// everything else out of RAM on small units.
+// Single reader: only one thread may use it at a time.
+class IoUringStreamBuf : public std::streambuf
+{
+public:
+    struct Options
+    {
+        bool ioUring = true;            // false = plain pread() of the same blocks
+        bool directIO = false;          // O_DIRECT - skips the page cache (falls back if unsupported)
+        bool dropBehind = true;         // Evict blocks from the page cache once they're read
+        uint32_t blockBytes = 0;        // 0 = tuned to the device (256 KiB - 4 MiB)
+        uint32_t blocksInFlight = 8;
+    };
+
+    IoUringStreamBuf() = default;
+    ~IoUringStreamBuf() override;
+
+    bool open(const std::string& path, const Options& options);
+    std::string getErrorMessage() const { return errorMessage; }
+
+    // Switches to another file (a replica of this one) with the same blocks and
+    // ring, starting again from offset 0. On failure nothing can be read until a
+    // later reopen() succeeds.
+    bool reopen(const std::string& path);
+
+    bool isUsingIoUring() const { return ringFd >= 0; }
+    bool isUsingDirectIO() const { return directIO; }
+    uint32_t getBlockBytes() const { return blockBytes; }
+    uint32_t getBlocksInFlight() const { return (uint32_t)slots.size(); }
+
+    // Telemetry - read from other threads
+    uint64_t getBlockReads() const { return blockReads.load(std::memory_order_relaxed); }
+    uint64_t getReadWaits() const { return readWaits.load(std::memory_order_relaxed); }  // The reader got there first
+    uint64_t getReadErrors() const { return readErrors.load(std::memory_order_relaxed); }
+
+protected:
+    int_type underflow() override;
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode) override;
+    pos_type seekpos(pos_type position, std::ios_base::openmode) override;
+
+private:
+    enum class SlotState { empty, inFlight, ready, failed };
+
+    struct Slot
+    {
+        int64_t block = -1;
+        SlotState state = SlotState::empty;
+        uint32_t bytes = 0;
+        char* data = nullptr;  // blockBytes, aligned for O_DIRECT
+    };
+
+    int fileFd = -1;
+    uint64_t fileSize = 0;
+    uint32_t blockBytes = 0;
+    bool directIO = false;
+    bool requestedDirectIO = false;
+    bool dropBehind = false;
+    int64_t lastBlock = -1;  // Last one the get area moved to, for the page cache hints
+    std::vector<Slot> slots;
+    uint64_t position = 0;  // Of the get area's start, or where the next read starts if it's empty
+    std::string errorMessage;
+
+    // io_uring, mapped by hand
+    int ringFd = -1;
+    void* sqRing = nullptr;
+    void* cqRing = nullptr;
+    size_t sqRingBytes = 0;
+    size_t cqRingBytes = 0;
+    struct io_uring_sqe* sqes = nullptr;
+    size_t sqesBytes = 0;
+    uint32_t* sqHead = nullptr;
+    uint32_t* sqTail = nullptr;
+    uint32_t* sqMask = nullptr;
+    uint32_t* sqArray = nullptr;
+    uint32_t* cqHead = nullptr;
+    uint32_t* cqTail = nullptr;
+    uint32_t* cqMask = nullptr;
+    struct io_uring_cqe* cqes = nullptr;
+    uint32_t pendingSubmissions = 0;
+
+    std::atomic<uint64_t> blockReads{0};
+    std::atomic<uint64_t> readWaits{0};
+    std::atomic<uint64_t> readErrors{0};
+
+    bool openFile(const std::string& path);
+    void drainReads();
+    static uint32_t getDeviceBlockBytes(int fd);
+    void adviseMovedTo(int64_t block);
+    bool setupRing(uint32_t entries);
+    void closeRing();
+    int64_t numBlocks() const { return (int64_t)((fileSize + blockBytes - 1) / blockBytes); }
+    Slot* findSlot(int64_t block);
+    Slot* findFreeSlot(int64_t fromBlock);
+    bool isInWindow(int64_t block, int64_t fromBlock) const;
+    Slot* loadBlock(int64_t block);
+    void readAhead(int64_t fromBlock);
+    bool submit(Slot& slot, int64_t block);
+    void queueRead(Slot& slot);
+    void flushSubmissions();
+    void reapCompletions(bool wait);
+};
+
+// The istream the decoder reads from, owning its buffer
+class IoUringFileStream : public std::istream
+{
+public:
+    IoUringFileStream() : std::istream(nullptr) { rdbuf(&buffer); }
+
+    bool open(const std::string& path, const IoUringStreamBuf::Options& options) { return buffer.open(path, options); }
+    bool reopen(const std::string& path) { clear(); return buffer.reopen(path); }
+    const IoUringStreamBuf& getBuffer() const { return buffer; }
+
+private:
+    IoUringStreamBuf buffer;
+};
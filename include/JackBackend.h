@@ -0,0 +1,77 @@
+#pragma once
+
+#include "AudioBackend.h"
+#include <jack/jack.h>
+#include <jack/midiport.h>
+#include <jack/transport.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+// JACK client: output_N ports auto-connected to system:playback, optional
+// midi_in / midi_out / ltc_out ports, and JACK transport with this player as
+// timebase master.
+class JackBackend : public AudioBackend
+{
+public:
+    JackBackend() = default;
+    ~JackBackend() override;
+
+    const char* getName() const override { return "jack"; }
+
+    bool open(const Options& options) override;
+    bool start(ProcessCallback callback) override;
+    void stop() override;
+
+    double getSampleRate() const override { return sampleRate; }
+    uint32_t getBlockSize() const override { return blockSize.load(std::memory_order_relaxed); }
+
+    bool hasMidiInput() const override { return midiInputPort != nullptr; }
+    bool hasMidiOutput() const override { return midiOutputPort != nullptr; }
+    bool hasLtcOutput() const override { return ltcOutputPort != nullptr; }
+
+    uint64_t getXrunCount() const override { return xruns.load(std::memory_order_relaxed); }
+    double getCpuLoad() const override { return client ? jack_cpu_load(client) : -1.0; }
+    uint32_t getOutputLatency() const override { return outputLatency.load(std::memory_order_relaxed); }
+    int getRealtimePriority() const override { return client && jack_is_realtime(client) ? std::max(0, jack_client_real_time_priority(client)) : 0; }
+
+    void transportStart() override { jack_transport_start(client); }
+    void transportStop() override { jack_transport_stop(client); }
+    void transportLocate(uint64_t frame) override { jack_transport_locate(client, (jack_nframes_t)frame); }
+
+    void setTimebaseSource(std::function<uint64_t()> frameSource) override { timebaseSource = std::move(frameSource); }
+
+    // For JACK-only helpers (MIDI auto-connect)
+    jack_client_t* getClient() const { return client; }
+    jack_port_t* getMidiInputPort() const { return midiInputPort; }
+
+private:
+    static constexpr uint32_t maxMidiEventsPerBlock = 256;
+
+    jack_client_t* client = nullptr;
+    std::vector<jack_port_t*> outputPorts;
+    std::vector<float*> outputBuffers;  // Filled per cycle
+    jack_port_t* midiInputPort = nullptr;
+    jack_port_t* midiOutputPort = nullptr;
+    jack_port_t* ltcOutputPort = nullptr;
+
+    double sampleRate = 0.0;
+    std::atomic<uint32_t> blockSize{0};
+    std::atomic<uint64_t> xruns{0};
+    std::atomic<uint32_t> outputLatency{0};
+    bool active = false;
+
+    ProcessCallback processCallback;
+    std::function<uint64_t()> timebaseSource;
+    MidiInputEvent midiEvents[maxMidiEventsPerBlock];
+
+    void connectOutputs();
+    void updateOutputLatency();
+
+    static int process(jack_nframes_t nframes, void* arg);
+    static int xrun(void* arg);
+    static int bufferSizeChanged(jack_nframes_t nframes, void* arg);
+    static void latencyChanged(jack_latency_callback_mode_t mode, void* arg);
+    static void timebase(jack_transport_state_t state, jack_nframes_t nframes,
+                         jack_position_t* pos, int newPosition, void* arg);
+};
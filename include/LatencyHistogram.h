@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Lock-free log-linear histogram: each power of two is split into 8 linear
+// sub-buckets (~12% resolution). observe() is a couple of relaxed atomic ops,
+// so it can be called from the JACK callback. Values are nanoseconds.
+class LatencyHistogram
+{
+public:
+    static constexpr int subBucketBits = 3;
+    static constexpr uint64_t subBuckets = 1u << subBucketBits;
+    static constexpr int maxBits = 40;  // ~18 minutes in ns - anything above lands in the last bucket
+    static constexpr size_t numBuckets = (maxBits - subBucketBits + 1) * subBuckets;
+
+    void observe(uint64_t value)
+    {
+        buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t previous = maxValue.load(std::memory_order_relaxed);
+        while (value > previous && !maxValue.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {}
+    }
+
+    // Not atomic as a whole - only for a histogram with a single writer that also resets it
+    void reset()
+    {
+        for (auto& bucket : buckets)
+            bucket.store(0, std::memory_order_relaxed);
+        count.store(0, std::memory_order_relaxed);
+        sum.store(0, std::memory_order_relaxed);
+        maxValue.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t getCount() const { return count.load(std::memory_order_relaxed); }
+    uint64_t getSum() const { return sum.load(std::memory_order_relaxed); }
+    uint64_t getMax() const { return maxValue.load(std::memory_order_relaxed); }
+
+    // Upper bound of the bucket holding the given quantile (0..1), 0 if empty
+    uint64_t getPercentile(double quantile) const
+    {
+        uint64_t total = getCount();
+        if (total == 0)
+            return 0;
+
+        auto target = static_cast<uint64_t>(quantile * static_cast<double>(total) + 0.5);
+        if (target < 1) target = 1;
+
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < numBuckets; ++i)
+        {
+            cumulative += buckets[i].load(std::memory_order_relaxed);
+            if (cumulative >= target)
+                return std::min(bucketUpperBound(i), getMax());
+        }
+        return getMax();
+    }
+
+    // Prometheus histogram with power-of-two 'le' boundaries (the sub-buckets fold into them
+    // exactly), from 1 us up. 'scale' converts ns to the exported unit (1e-9 for seconds).
+    // For several label sets under one name, pass help = nullptr after the first to skip the header.
+    void writePrometheus(std::string& out, const char* name, const char* help,
+                         double scale = 1e-9, const char* labels = nullptr) const
+    {
+        char line[256];
+        if (help)
+        {
+            std::snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+            out += line;
+        }
+
+        std::string prefix = labels ? std::string(labels) + "," : std::string();
+        std::string suffix = labels ? "{" + std::string(labels) + "}" : std::string();
+
+        uint64_t cumulative = 0;
+        size_t bucket = 0;
+        for (int bits = 10; bits <= maxBits; ++bits)
+        {
+            uint64_t bound = uint64_t(1) << bits;
+            for (; bucket < numBuckets && bucketUpperBound(bucket) <= bound; ++bucket)
+                cumulative += buckets[bucket].load(std::memory_order_relaxed);
+
+            std::snprintf(line, sizeof(line), "%s_bucket{%sle=\"%g\"} %llu\n", name, prefix.c_str(), bound * scale,
+                          static_cast<unsigned long long>(cumulative));
+            out += line;
+        }
+
+        std::snprintf(line, sizeof(line), "%s_bucket{%sle=\"+Inf\"} %llu\n%s_sum%s %g\n%s_count%s %llu\n",
+                      name, prefix.c_str(), static_cast<unsigned long long>(getCount()),
+                      name, suffix.c_str(), getSum() * scale,
+                      name, suffix.c_str(), static_cast<unsigned long long>(getCount()));
+        out += line;
+    }
+
+private:
+    std::atomic<uint64_t> buckets[numBuckets] = {};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> maxValue{0};
+
+    static size_t bucketIndex(uint64_t value)
+    {
+        if (value < subBuckets)
+            return static_cast<size_t>(value);
+
+        int topBit = std::bit_width(value) - 1;
+        if (topBit >= maxBits)
+            return numBuckets - 1;
+
+        int shift = topBit - subBucketBits;
+        auto subBucket = static_cast<size_t>((value >> shift) & (subBuckets - 1));
+        return static_cast<size_t>(topBit - subBucketBits + 1) * subBuckets + subBucket;
+    }
+
+    static uint64_t bucketUpperBound(size_t index)
+    {
+        if (index < subBuckets)
+            return index + 1;
+
+        int shift = static_cast<int>(index / subBuckets) - 1;
+        uint64_t subBucket = index % subBuckets;
+        return (subBuckets + subBucket + 1) << shift;
+    }
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Timecode.h"
+#include "choc/threading/choc_TaskThread.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Linear timecode (SMPTE LTC) generator for an extra JACK output port.
+// A background thread encodes upcoming timecode frames into a small ring of
+// slots ahead of the play head; the JACK callback only copies samples out.
+class LtcGenerator
+{
+public:
+    LtcGenerator(double sampleRate, TimecodeRate rate, float levelDb);
+    ~LtcGenerator();
+
+    // Timeline length in output frames - timecode wraps with the file loop
+    void setTimelineLength(uint64_t outputFrames);
+
+    // Play head source (BufferedAudioFilePlayer::getCurrentOutputFrame) used to precompute ahead
+    void start(std::function<uint64_t()> playheadSource);
+    void stop();
+
+    // Wake the encoder after a seek or stop so the new position is ready quickly (control thread only)
+    void resync() { encoderThread.trigger(); }
+
+    // Called from the JACK callback: copies LTC for [blockStartFrame, blockStartFrame + numFrames).
+    // Outputs silence when not rolling or when a frame isn't ready yet (e.g. right after a seek).
+    void renderBlock(float* output, uint32_t numFrames, uint64_t blockStartFrame, bool isRolling);
+
+    // Number of blocks that hit a frame the encoder hadn't prepared yet
+    uint64_t getMissedFrameCount() const { return missedFrames.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint32_t numSlots = 16;  // ~0.5 s of timecode ahead of the play head
+    static constexpr uint64_t emptySlot = ~uint64_t(0);
+
+    // One encoded LTC frame. 'sequence' counts frames across loop wraps, so consecutive
+    // frames always land in different slots even when the timeline restarts at 00:00:00:00.
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence{emptySlot};
+        std::vector<float> samples;
+    };
+
+    uint64_t sampleRate;
+    TimecodeRate rate;
+    float amplitude;
+
+    std::atomic<uint64_t> timelineLength{0};
+    std::atomic<uint64_t> framesPerLoop{0};
+
+    std::unique_ptr<Slot[]> slots;
+    uint32_t maxSamplesPerFrame = 0;
+
+    std::function<uint64_t()> playheadSource;
+    choc::threading::TaskThread encoderThread;
+    std::atomic<uint64_t> missedFrames{0};
+
+    uint64_t sequenceAt(uint64_t position, uint64_t length, uint64_t loopFrames) const;
+    void sequenceRange(uint64_t sequence, uint64_t length, uint64_t loopFrames,
+                       uint64_t& start, uint64_t& end) const;
+    void encoderTask();
+    void encodeFrame(uint64_t frameIndex, float* dest, uint32_t numSamples) const;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Serves metrics in Prometheus text format from its own (non-realtime) thread.
+// Collectors only read atomics that the audio and loader threads update, so
+// scraping never touches the hot paths. Speaks just enough HTTP for Prometheus
+// and curl, e.g. curl --unix-socket /run/consoleAudioPlayer.sock http://x/metrics
+class MetricsServer
+{
+public:
+    using Collector = std::function<void(std::string&)>;
+
+    MetricsServer() = default;
+    ~MetricsServer();
+
+    void addCollector(Collector collector);  // Before start()
+
+    // "unix:/path/to.sock" or "host:port" (e.g. "127.0.0.1:9099")
+    bool start(const std::string& address);
+    void stop();
+
+    std::string getErrorMessage() const { return errorMessage; }
+
+    // Text exposition helpers for collectors
+    static void writeCounter(std::string& out, const char* name, const char* help, double value);
+    static void writeGauge(std::string& out, const char* name, const char* help, double value);
+
+private:
+    std::vector<Collector> collectors;
+    std::thread serverThread;
+    int listenFd = -1;
+    int wakeFd = -1;  // eventfd used to stop the server thread
+    std::string unixSocketPath;
+    std::string errorMessage;
+
+    bool openListener(const std::string& address);
+    void serve();
+    void handleClient(int clientFd);
+};
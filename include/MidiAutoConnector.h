@@ -0,0 +1,43 @@
+#pragma once
+
+#include "choc/threading/choc_TaskThread.h"
+#include <jack/jack.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Keeps the MIDI input connected to the first controller whose port name matches
+// one of the configured patterns (case-insensitive substring). Driven by JACK port
+// registration/connection notifications instead of polling: the notification
+// callbacks only wake a worker, which does the port scan and jack_connect()
+// (JACK API calls aren't allowed from inside notification callbacks).
+class MidiAutoConnector
+{
+public:
+    MidiAutoConnector(jack_client_t* client, jack_port_t* midiInputPort, std::vector<std::string> devicePatterns);
+    ~MidiAutoConnector();
+
+    // Must be called before jack_activate() - registers the notification callbacks
+    bool registerCallbacks();
+
+    // Call after jack_activate(): makes the initial connection attempt and starts listening
+    void start();
+    void stop();
+
+    uint64_t getReconnectCount() const { return reconnectCount.load(std::memory_order_relaxed); }
+
+private:
+    jack_client_t* client;
+    jack_port_t* midiInputPort;
+    std::vector<std::string> patterns;  // Lower-cased once here, not on every scan
+
+    choc::threading::TaskThread worker;
+    bool reportedMissing = false;
+    std::atomic<uint64_t> reconnectCount{0};
+
+    static void portRegistrationCallback(jack_port_id_t port, int registered, void* arg);
+    static void portConnectCallback(jack_port_id_t a, jack_port_id_t b, int connected, void* arg);
+
+    void reconnectIfNeeded();
+    bool matchesPattern(const char* portName) const;
+};
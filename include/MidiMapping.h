@@ -0,0 +1,111 @@
+#pragma once
+
+#include "choc/text/choc_JSON.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class MidiAction : uint8_t
+{
+    none,
+    play,
+    pause,
+    togglePause,   // Pause if playing, otherwise play (like SPACE)
+    pauseOrStop,   // Pause if playing, otherwise stop and reset (classic CC2)
+    stop,
+    gain,          // Continuous: CC value / note velocity -> 0..1
+    seek,          // Relative seek by 'parameter' seconds (negative = backwards)
+    cue,           // Jump to cuePoints['parameter']
+    next,          // Jump to the next cue point after the play head
+    previous       // Jump to the last cue point before the play head
+};
+
+enum class MidiMessageType : uint8_t
+{
+    controlChange,
+    note,
+    programChange
+};
+
+// One entry of the "midiMapping" config array, e.g.
+// { "type": "cc", "channel": 1, "number": 7, "action": "gain" }
+struct MidiBinding
+{
+    MidiMessageType type = MidiMessageType::controlChange;
+    int channel = -1;       // 1-16 in JSON, stored 0-15; -1 = any channel
+    uint8_t number = 0;     // CC / note / program number
+    MidiAction action = MidiAction::none;
+    float parameter = 0.0f; // seek: seconds, cue: cue index
+};
+
+// What a message maps to, as seen by the process callback
+struct MidiControl
+{
+    MidiAction action = MidiAction::none;
+    float parameter = 0.0f;
+    float value = 0.0f;     // CC value or velocity, 0..1
+    bool pressed = false;   // CC >= 64, note-on, or program change - fires trigger actions
+};
+
+// Bindings compiled into a flat table indexed by (type, channel, number), so the
+// process callback dispatches with a single array lookup. Immutable once built:
+// it is published inside the live config snapshot, so the callback sees it
+// change together with the rest of the config, and the old one is only freed
+// after the callback has let go of that snapshot.
+class MidiTable
+{
+public:
+    MidiTable() = default;  // Nothing bound
+    explicit MidiTable(const std::vector<MidiBinding>& bindings);
+
+    // Process callback
+    MidiControl lookup(const uint8_t* data, size_t size) const;
+
+    static bool decode(const uint8_t* data, size_t size, MidiMessageType& type,
+                       uint8_t& channel, uint8_t& number, uint8_t& value);
+
+private:
+    struct Entry
+    {
+        MidiAction action = MidiAction::none;
+        float parameter = 0.0f;
+    };
+
+    static constexpr size_t numTypes = 3;
+    static constexpr size_t tableSize = numTypes * 16 * 128;
+
+    std::vector<Entry> entries;
+
+    static size_t tableIndex(MidiMessageType type, uint8_t channel, uint8_t number)
+    {
+        return (static_cast<size_t>(type) * 16 + channel) * 128 + number;
+    }
+};
+
+// Learn mode, shared between the process callback and the control thread, and
+// the helpers for the "midiMapping" config
+class MidiMapping
+{
+public:
+    // Learn mode: the next CC / note-on / program change is captured instead of dispatched
+    void armLearn() { learnedMessage.store(0, std::memory_order_relaxed); learnArmed.store(true, std::memory_order_release); }
+    bool isLearning() const { return learnArmed.load(std::memory_order_acquire); }
+    bool getLearnedMessage(MidiBinding& binding);
+
+    // Process callback
+    bool captureIfLearning(const uint8_t* data, size_t size);
+
+    // Config helpers
+    static void addBinding(std::vector<MidiBinding>& bindings, const MidiBinding& binding);  // Replaces any binding for the same message
+    static std::vector<MidiBinding> parseBindings(const choc::value::ValueView& json);
+    static std::vector<MidiBinding> defaultBindings(int numCuePoints, int cueBaseNote);
+    static std::string toJson(const MidiBinding& binding);
+    static const char* actionName(MidiAction action);
+    static MidiAction actionFromName(std::string_view name);
+
+private:
+    std::atomic<bool> learnArmed{false};
+    std::atomic<uint32_t> learnedMessage{0};  // (status << 8 | number) + 1, 0 = nothing yet
+};
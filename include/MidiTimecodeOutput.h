@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Timecode.h"
+#include <cstdint>
+#include <cstddef>
+
+// MIDI Time Code quarter-frames and optional MIDI beat clock, rendered sample-accurately
+// into a JACK MIDI output buffer from the process callback. Everything here is
+// allocation-free; positions are output frames as reported by getCurrentOutputFrame().
+class MidiTimecodeOutput
+{
+public:
+    MidiTimecodeOutput(double sampleRate, TimecodeRate rate, bool sendMtc, bool sendClock, double clockBpm);
+
+    // Timeline length in output frames - timecode and clock restart with the file loop
+    void setTimelineLength(uint64_t outputFrames) { timelineLength = outputFrames > 0 ? outputFrames : 1; }
+
+    // Called from the JACK callback after processBlock(). Clears 'midiBuffer' and writes this
+    // block's events at their in-block offsets. Pauses, stops, seeks and loop wraps are
+    // detected from discontinuities in blockStartFrame/isRolling.
+    void renderBlock(void* midiBuffer, uint32_t numFrames, uint64_t blockStartFrame, bool isRolling);
+
+private:
+    struct Event
+    {
+        uint32_t offset;
+        uint8_t size;
+        uint8_t data[10];
+    };
+
+    static constexpr size_t maxEventsPerBlock = 128;
+
+    double sampleRate;
+    TimecodeRate rate;
+    TimecodeRate quarterFrameRate;  // Same ratio at 4x, so quarter-frame times use the same exact math
+    bool sendMtc;
+    bool sendClock;
+    double samplesPerClock;
+    uint64_t timelineLength = 1;
+
+    // Transport as seen by the previous block
+    bool wasRolling = false;
+    uint64_t expectedNextFrame = 0;
+    uint64_t lastIdleFrame = ~uint64_t(0);
+
+    Event events[maxEventsPerBlock];
+    size_t numEvents = 0;
+
+    void addEvent(uint32_t offset, const uint8_t* data, uint8_t size);
+    void addFullFrame(uint32_t offset, uint64_t timelineFrame);
+    void addClockLocate(uint32_t offset, uint64_t timelineFrame, bool restart);
+    void renderSegment(uint32_t offset, uint32_t numFrames, uint64_t timelineFrame);
+    uint8_t mtcRateCode() const;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "AudioBackend.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// No audio device: a thread calls the process callback once per period, on a
+// steady clock, and the output is thrown away. Behaves like a sound card for
+// load testing the loader, FIFO and callback on machines without hardware.
+// A cycle that starts more than a period late counts as an xrun.
+class NullBackend : public AudioBackend
+{
+public:
+    NullBackend() = default;
+    ~NullBackend() override;
+
+    const char* getName() const override { return "null"; }
+
+    bool open(const Options& options) override;
+    bool start(ProcessCallback callback) override;
+    void stop() override;
+
+    double getSampleRate() const override { return sampleRate; }
+    uint32_t getBlockSize() const override { return blockSize; }
+
+    bool hasLtcOutput() const override { return !ltcBuffer.empty(); }
+    uint64_t getXrunCount() const override { return xruns.load(std::memory_order_relaxed); }
+
+private:
+    double sampleRate = 48000.0;
+    uint32_t blockSize = 64;
+
+    std::vector<std::vector<float>> channelData;
+    std::vector<float*> channelPointers;
+    std::vector<float> ltcBuffer;
+
+    ProcessCallback processCallback;
+    std::thread processThread;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> xruns{0};
+
+    void run();
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Drives BufferedAudioFilePlayer without JACK: processBlock() is called from a
+// simulated clock and the output written to a WAV file. Flat out by default
+// (a throughput benchmark - the realtime factor is reported), or paced at real
+// time with the normal loader thread to reproduce live behaviour.
+//
+// Flat-out renders load the FIFO on the same thread between blocks, so the
+// same options always give bit-identical output (32-bit float WAV) - usable
+// as golden files for resampling, looping and seeking.
+class OfflineRenderer
+{
+public:
+    struct Seek
+    {
+        double atSeconds = 0.0;    // Output timeline position that triggers it
+        double toSeconds = 0.0;    // File position to jump to
+    };
+
+    struct Options
+    {
+        std::string inputPath;
+        std::string outputPath;
+        double sampleRate = 48000.0;
+        uint32_t blockSize = 64;
+        uint32_t numChannels = 2;
+        double durationSeconds = 0.0;  // 0 = one pass of the file
+        bool realtime = false;
+        std::vector<Seek> seeks;
+    };
+
+    explicit OfflineRenderer(Options options);
+
+    int run();  // Process exit code
+
+private:
+    Options options;
+};
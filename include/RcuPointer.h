@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Immutable snapshot shared between the control thread (writer) and the
+// process callback (the one reader). The reader takes the current pointer at
+// the start of a cycle and calls quiescent() at the end; the writer publishes
+// a replacement with one pointer swap and frees the old snapshot only once the
+// reader has finished a cycle that started after the swap. Reads are a single
+// atomic load - no locks, no reference counts, no frees on the audio thread.
+template <typename T>
+class RcuPointer
+{
+public:
+    explicit RcuPointer(std::unique_ptr<const T> initial) : current(initial.release()) {}
+
+    ~RcuPointer()
+    {
+        delete current.load();
+        for (auto& old : retired)
+            delete old.snapshot;
+    }
+
+    RcuPointer(const RcuPointer&) = delete;
+    RcuPointer& operator=(const RcuPointer&) = delete;
+
+    // Reader: valid until the reader's next quiescent()
+    const T* read() const { return current.load(std::memory_order_seq_cst); }
+    void quiescent() { readerCycles.fetch_add(1, std::memory_order_seq_cst); }
+
+    // Writer: its own view never goes away under it
+    const T& get() const { return *current.load(std::memory_order_relaxed); }
+
+    void publish(std::unique_ptr<const T> next)
+    {
+        const T* previous = current.exchange(next.release(), std::memory_order_seq_cst);
+        retired.push_back({ previous, readerCycles.load(std::memory_order_seq_cst) });
+        reclaim();
+    }
+
+    // Frees retired snapshots the reader can no longer be holding. Called on
+    // every publish(); call it periodically too if reloads are rare.
+    void reclaim()
+    {
+        uint64_t cycles = readerCycles.load(std::memory_order_seq_cst);
+        size_t kept = 0;
+        for (auto& old : retired)
+        {
+            if (cycles > old.readerCyclesAtRetire)
+                delete old.snapshot;
+            else
+                retired[kept++] = old;
+        }
+        retired.resize(kept);
+    }
+
+    size_t getRetiredCount() const { return retired.size(); }
+
+private:
+    struct Retired
+    {
+        const T* snapshot;
+        uint64_t readerCyclesAtRetire;
+    };
+
+    std::atomic<const T*> current;
+    std::atomic<uint64_t> readerCycles{0};
+    std::vector<Retired> retired;  // Writer only
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "choc/threading/choc_TaskThread.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+// Bounded lock-free log ring that any thread - including the JACK callback -
+// can write to without blocking. Each call formats into a fixed-size record
+// in place (vsnprintf, no allocation); a background thread drains the ring to
+// stdout, a file or syslog. When the ring is full the record is dropped and
+// counted rather than waiting for the writer.
+class RealtimeLogger
+{
+public:
+    enum class Level : uint8_t
+    {
+        debug,
+        info,
+        warning,
+        error
+    };
+
+    // Process-wide instance. Records logged before start() wait in the ring.
+    static RealtimeLogger& get();
+
+    ~RealtimeLogger();
+
+    // "stdout", "syslog" or "file:/path/to.log"
+    bool start(const std::string& target);
+    void stop();  // Drains what's left, then closes the sink
+
+    void setMinimumLevel(Level level) { minimumLevel.store(level, std::memory_order_relaxed); }
+    bool isEnabled(Level level) const { return level >= minimumLevel.load(std::memory_order_relaxed); }
+
+    void log(Level level, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+    uint64_t getDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+    std::string getErrorMessage() const { return errorMessage; }
+
+    static bool parseLevel(const std::string& name, Level& level);
+
+private:
+    RealtimeLogger();
+
+    static constexpr uint32_t numSlots = 1024;  // Power of two
+    static constexpr size_t maxTextLength = 240;
+
+    struct Record
+    {
+        uint64_t timestampNs = 0;  // CLOCK_REALTIME
+        Level level = Level::info;
+        uint16_t length = 0;
+        char text[maxTextLength];
+    };
+
+    // Multi-producer / single-consumer ring: a slot's sequence says whose turn it is
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence{0};
+        Record record;
+    };
+
+    enum class Sink
+    {
+        console,
+        file,
+        syslog
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<uint64_t> writePosition{0};
+    alignas(64) uint64_t readPosition = 0;  // Writer thread only
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<Level> minimumLevel{Level::info};
+
+    Sink sink = Sink::console;
+    FILE* logFile = nullptr;
+    bool started = false;
+    uint64_t reportedDrops = 0;
+    std::string errorMessage;
+
+    choc::threading::TaskThread writerThread;
+
+    void drain();
+    void write(const Record& record);
+};
+
+// Shorthands - cheap enough for the process callback
+#define RT_LOG_DEBUG(...) do { if (RealtimeLogger::get().isEnabled(RealtimeLogger::Level::debug)) \
+                                   RealtimeLogger::get().log(RealtimeLogger::Level::debug, __VA_ARGS__); } while (0)
+#define RT_LOG_INFO(...)    RealtimeLogger::get().log(RealtimeLogger::Level::info, __VA_ARGS__)
+#define RT_LOG_WARNING(...) RealtimeLogger::get().log(RealtimeLogger::Level::warning, __VA_ARGS__)
+#define RT_LOG_ERROR(...)   RealtimeLogger::get().log(RealtimeLogger::Level::error, __VA_ARGS__)
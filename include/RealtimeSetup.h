@@ -0,0 +1,37 @@
+#pragma once
+
+#include <pthread.h>
+#include <cstddef>
+#include <string>
+
+// Process and thread hardening for dedicated playback machines: lock memory,
+// fault pages in before the first callback touches them, and pin / prioritise
+// the loader thread. All best effort - without the privileges (CAP_IPC_LOCK,
+// CAP_SYS_NICE or matching rlimits) the player still runs, and each call
+// returns a line describing what it actually achieved.
+class RealtimeSetup
+{
+public:
+    // mlockall(MCL_CURRENT): locks what is mapped now. Call once the buffers are
+    // allocated and prefaulted and the threads exist. No MCL_FUTURE - past
+    // RLIMIT_MEMLOCK that makes later allocations (a FIFO, a thread stack) fail
+    // outright instead of just going unlocked.
+    static bool lockMemory(std::string& report);
+
+    // Writes every page back to itself so it is resident, contents unchanged
+    static void prefault(void* data, size_t numBytes);
+
+    // Faults in the top of the calling thread's stack
+    static void prefaultStack();
+
+    // Pins 'thread' to 'cpu' (-1 = any) and runs it SCHED_FIFO at 'priority',
+    // or SCHED_OTHER when priority is 0
+    static std::string configureThread(pthread_t thread, int cpu, int priority);
+
+    // Loader priority for a requested value (-1 = auto) that stays below the
+    // audio thread's. 0 (SCHED_OTHER) when the audio thread isn't realtime itself.
+    static int loaderPriorityBelow(int audioPriority, int requested);
+
+private:
+    static constexpr size_t stackPrefaultBytes = 128 * 1024;
+};
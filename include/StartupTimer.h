@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Wall time of each startup phase, for the time-to-first-sample report.
+// Phases are consecutive marks on the main thread; work that ran on another
+// thread alongside them is listed separately and not added to the total.
+class StartupTimer
+{
+public:
+    StartupTimer() : startTime(now()), lastMark(startTime) {}
+
+    static uint64_t now()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Ends the current phase
+    void phase(const std::string& name)
+    {
+        uint64_t time = now();
+        phases.push_back({ name, time - lastMark, false });
+        lastMark = time;
+    }
+
+    // Something that ran on another thread, overlapping the main thread's phases
+    void parallel(const std::string& name, uint64_t durationNs)
+    {
+        phases.push_back({ name, durationNs, true });
+    }
+
+    // 'firstSampleTime' is now() as seen by the first process callback
+    std::string getReport(uint64_t firstSampleTime) const
+    {
+        char line[160];
+        std::string report;
+
+        std::snprintf(line, sizeof(line), "Startup: first sample after %.1f ms\n", (firstSampleTime - startTime) / 1e6);
+        report += line;
+
+        for (const auto& entry : phases)
+        {
+            std::snprintf(line, sizeof(line), "  %-24s %8.1f ms%s\n", entry.name.c_str(), entry.durationNs / 1e6,
+                          entry.parallel ? "  (in parallel)" : "");
+            report += line;
+        }
+
+        if (firstSampleTime > lastMark)
+        {
+            std::snprintf(line, sizeof(line), "  %-24s %8.1f ms\n", "first callback", (firstSampleTime - lastMark) / 1e6);
+            report += line;
+        }
+        return report;
+    }
+
+private:
+    struct Phase
+    {
+        std::string name;
+        uint64_t durationNs;
+        bool parallel;
+    };
+
+    uint64_t startTime;
+    uint64_t lastMark;
+    std::vector<Phase> phases;
+};
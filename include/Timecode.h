@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+// SMPTE timecode helpers shared by the LTC and MTC generators
+struct Timecode
+{
+    uint32_t hours = 0;
+    uint32_t minutes = 0;
+    uint32_t seconds = 0;
+    uint32_t frames = 0;
+};
+
+// Frame rate kept as an exact ratio so 29.97 fps maps onto whole sample counts
+struct TimecodeRate
+{
+    uint32_t numerator = 25;
+    uint32_t denominator = 1;
+    uint32_t nominalFps = 25;  // Frames counted per timecode second (30 for 29.97)
+    bool dropFrame = false;
+
+    // 24, 25, 30, or 30 + dropFrame (29.97 DF). Anything else falls back to 25.
+    static TimecodeRate fromSettings(int fps, bool dropFrame)
+    {
+        switch (fps)
+        {
+            case 24: return { 24, 1, 24, false };
+            case 30: return dropFrame ? TimecodeRate { 30000, 1001, 30, true }
+                                      : TimecodeRate { 30, 1, 30, false };
+            default: return { 25, 1, 25, false };
+        }
+    }
+
+    // First sample of timecode frame 'frameIndex' (rounded up so frameIndexAt() is its exact inverse)
+    uint64_t frameStartSample(uint64_t frameIndex, uint64_t sampleRate) const
+    {
+        return (frameIndex * sampleRate * denominator + numerator - 1) / numerator;
+    }
+
+    // Timecode frame containing sample 'sample'
+    uint64_t frameIndexAt(uint64_t sample, uint64_t sampleRate) const
+    {
+        return (sample * numerator) / (sampleRate * denominator);
+    }
+};
+
+// Convert a running frame count into hh:mm:ss:ff, skipping dropped frame numbers for 29.97 DF
+inline Timecode frameIndexToTimecode(uint64_t frameIndex, const TimecodeRate& rate)
+{
+    if (rate.dropFrame)
+    {
+        // Frame numbers 0 and 1 are skipped every minute except every tenth minute
+        constexpr uint64_t framesPer10Minutes = 17982;
+        constexpr uint64_t framesPerMinute = 1798;
+
+        uint64_t tens = frameIndex / framesPer10Minutes;
+        uint64_t remainder = frameIndex % framesPer10Minutes;
+
+        frameIndex += 18 * tens;
+        if (remainder >= 2)
+            frameIndex += 2 * ((remainder - 2) / framesPerMinute);
+    }
+
+    Timecode tc;
+    tc.frames  = static_cast<uint32_t>(frameIndex % rate.nominalFps);
+    uint64_t totalSeconds = frameIndex / rate.nominalFps;
+    tc.seconds = static_cast<uint32_t>(totalSeconds % 60);
+    tc.minutes = static_cast<uint32_t>((totalSeconds / 60) % 60);
+    tc.hours   = static_cast<uint32_t>((totalSeconds / 3600) % 24);
+    return tc;
+}
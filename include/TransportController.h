@@ -0,0 +1,71 @@
+#pragma once
+
+#include "AudioBackend.h"
+#include "BufferedAudioFilePlayer.h"
+#include "ControlReactor.h"
+#include "LtcGenerator.h"
+#include <atomic>
+#include <cstdint>
+
+enum class TransportState
+{
+    stopped,     // At 0 with the start of the file buffered - play is instant
+    prerolling,  // Refilling from 0 after a stop
+    playing,
+    paused,
+    seeking      // Refilling at a new position
+};
+
+// Play / pause / stop / seek, owned by the control thread. The keyboard and the
+// audio callback only ask for transitions; the player and the JACK transport are
+// touched here, once per transition. After a stop or seek the FIFO starts empty,
+// so the controller waits in prerolling / seeking until the loader reports that
+// enough is buffered, then moves on to where it was asked to go.
+class TransportController
+{
+public:
+    // 'readySeconds' must be buffered before leaving prerolling / seeking
+    TransportController(ControlReactor& reactor, BufferedAudioFilePlayer& player, AudioBackend& backend,
+                        LtcGenerator* ltcGenerator, double readySeconds);
+
+    void play();
+    void pause();  // Also cancels the play at the end of a preroll or seek
+    void togglePause();
+    void stop();
+    void pauseOrStop();  // Pause if playing, otherwise stop
+    void seek(uint64_t fileFrame, bool thenPlay = false);
+
+    // Call when the loader signals (BufferedAudioFilePlayer::setBufferedCallback)
+    void update();
+
+    TransportState getState() const { return state; }
+    static const char* stateName(TransportState state);
+
+    // Realtime safe: the timebase reports 0 while stopped
+    bool isHoldingAtZero() const { return holdingAtZero.load(std::memory_order_acquire); }
+
+    // Realtime safe, from the audio callback: starts the player right away if it's
+    // paused or stopped and prerolled. False if play has to wait for play().
+    bool playFromCallback();
+
+private:
+    ControlReactor& reactor;
+    BufferedAudioFilePlayer& player;
+    AudioBackend& backend;
+    LtcGenerator* ltcGenerator;
+    double readySeconds;
+
+    TransportState state = TransportState::playing;
+    bool playWhenReady = false;  // Where prerolling / seeking goes next
+    int readyTimeout = -1;
+    std::atomic<bool> holdingAtZero{false};
+    std::atomic<bool> canPlayFromCallback{false};
+
+    static constexpr uint32_t readyTimeoutMs = 1000;
+
+    void setState(TransportState newState);
+    bool isWaiting() const { return state == TransportState::prerolling || state == TransportState::seeking; }
+    void waitForBuffer(TransportState waitingState, bool thenPlay);
+    void bufferReady();
+    void startPlaying();
+};
@@ -0,0 +1,328 @@
+#include "../include/AlsaBackend.h"
+#include "../include/RealtimeLogger.h"
+#include "../include/RealtimeSetup.h"
+#include <pthread.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    // Clamp to [-1, 1] and scale to the nearest integer, as the vector conversions
+    // round, so the tail of a period isn't quantised differently from the rest
+    inline int32_t convert1(float in, float scale)
+    {
+        return (int32_t)std::lrintf(std::clamp(in, -1.0f, 1.0f) * scale);
+    }
+
+    // Clamp to [-1, 1] and scale four samples to integers
+    inline void convert4(const float* in, float scale, int32_t* out)
+    {
+#if defined(__SSE2__)
+        __m128 x = _mm_loadu_ps(in);
+        x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+        _mm_storeu_si128((__m128i*)out, _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(scale))));
+#elif defined(__aarch64__)
+        float32x4_t x = vld1q_f32(in);
+        x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(-1.0f)), vdupq_n_f32(1.0f));
+        vst1q_s32(out, vcvtnq_s32_f32(vmulq_n_f32(x, scale)));  // To nearest; 32-bit NEON only truncates
+#else
+        for (int i = 0; i < 4; ++i)
+            out[i] = convert1(in[i], scale);
+#endif
+    }
+
+    // One channel into its slot of the interleaved DMA area, 'stride' bytes per frame.
+    // Store writes the low bytes of each converted sample in the device format.
+    template <typename Store>
+    void convertChannel(const float* in, uint8_t* out, size_t stride, uint32_t numFrames, float scale, Store store)
+    {
+        int32_t converted[4];
+        uint32_t frame = 0;
+
+        for (; frame + 4 <= numFrames; frame += 4)
+        {
+            convert4(in + frame, scale, converted);
+            for (int i = 0; i < 4; ++i)
+                store(out + (frame + i) * stride, converted[i]);
+        }
+
+        for (; frame < numFrames; ++frame)
+            store(out + frame * stride, convert1(in[frame], scale));
+    }
+}
+
+AlsaBackend::~AlsaBackend()
+{
+    stop();
+    if (pcm)
+        snd_pcm_close(pcm);
+}
+
+bool AlsaBackend::open(const Options& options)
+{
+    deviceName = options.device.empty() ? "default" : options.device;
+
+    int err = snd_pcm_open(&pcm, deviceName.c_str(), SND_PCM_STREAM_PLAYBACK, 0);
+    if (err < 0)
+    {
+        errorMessage = "Cannot open ALSA device " + deviceName + ": " + snd_strerror(err);
+        pcm = nullptr;
+        return false;
+    }
+
+    if (!configure(options))
+        return false;
+
+    channelData.assign(numChannels, std::vector<float>(periodFrames, 0.0f));
+    channelPointers.clear();
+    for (auto& channel : channelData)
+        channelPointers.push_back(channel.data());
+
+    return true;
+}
+
+bool AlsaBackend::configure(const Options& options)
+{
+    snd_pcm_hw_params_t* hw = nullptr;
+    snd_pcm_hw_params_malloc(&hw);
+
+    auto fail = [&] (const std::string& what, int err)
+    {
+        errorMessage = "ALSA " + deviceName + ": " + what + ": " + snd_strerror(err);
+        snd_pcm_hw_params_free(hw);
+        return false;
+    };
+
+    int err = snd_pcm_hw_params_any(pcm, hw);
+    if (err < 0) return fail("no configurations available", err);
+
+    err = snd_pcm_hw_params_set_access(pcm, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED);
+    if (err < 0) return fail("mmap access not supported", err);
+
+    // The converter's native formats, best first - USB interfaces often only take packed 24-bit
+    err = -EINVAL;
+    for (auto candidate : { SND_PCM_FORMAT_S32_LE, SND_PCM_FORMAT_S24_3LE, SND_PCM_FORMAT_S16_LE })
+    {
+        err = snd_pcm_hw_params_set_format(pcm, hw, candidate);
+        if (err == 0)
+        {
+            format = candidate;
+            break;
+        }
+    }
+    if (err < 0) return fail("none of S32_LE, S24_3LE or S16_LE supported", err);
+
+    numChannels = options.numOutputChannels;
+    err = snd_pcm_hw_params_set_channels(pcm, hw, numChannels);
+    if (err < 0) return fail(std::to_string(numChannels) + " channels not supported", err);
+
+    unsigned int rate = (unsigned int)options.sampleRate;
+    err = snd_pcm_hw_params_set_rate_near(pcm, hw, &rate, nullptr);
+    if (err < 0) return fail("cannot set sample rate", err);
+
+    snd_pcm_uframes_t period = options.blockSize;
+    err = snd_pcm_hw_params_set_period_size_near(pcm, hw, &period, nullptr);
+    if (err < 0) return fail("cannot set period size", err);
+
+    // Three periods: one playing, one queued, one being rendered. A whole
+    // number of them, so a period never wraps around the end of the DMA buffer
+    err = snd_pcm_hw_params_set_periods_integer(pcm, hw);
+    if (err < 0) return fail("cannot use an integral period count", err);
+
+    unsigned int periods = 3;
+    err = snd_pcm_hw_params_set_periods_near(pcm, hw, &periods, nullptr);
+    if (err < 0) return fail("cannot set period count", err);
+
+    err = snd_pcm_hw_params(pcm, hw);
+    if (err < 0) return fail("cannot apply hardware parameters", err);
+
+    snd_pcm_hw_params_get_period_size(hw, &period, nullptr);
+    snd_pcm_uframes_t buffer = 0;
+    snd_pcm_hw_params_get_buffer_size(hw, &buffer);
+    snd_pcm_hw_params_free(hw);
+
+    // A rendered period is written once a period is free, so the rest of the buffer is queued ahead of it
+    sampleRate = rate;
+    periodFrames = (uint32_t)period;
+    bufferFrames = (uint32_t)buffer;
+
+    // Start once the buffer is full; wake up whenever a whole period is free
+    snd_pcm_sw_params_t* sw = nullptr;
+    snd_pcm_sw_params_malloc(&sw);
+    snd_pcm_sw_params_current(pcm, sw);
+    snd_pcm_sw_params_set_start_threshold(pcm, sw, buffer);
+    snd_pcm_sw_params_set_avail_min(pcm, sw, period);
+    err = snd_pcm_sw_params(pcm, sw);
+    snd_pcm_sw_params_free(sw);
+    if (err < 0)
+    {
+        errorMessage = "ALSA " + deviceName + ": cannot apply software parameters: " + snd_strerror(err);
+        return false;
+    }
+
+    std::cout << "ALSA: " << deviceName << " " << numChannels << "ch @ " << rate << " Hz, "
+              << periodFrames << " x " << (buffer / std::max<snd_pcm_uframes_t>(period, 1)) << " frames, "
+              << snd_pcm_format_name(format) << std::endl;
+    return true;
+}
+
+bool AlsaBackend::start(ProcessCallback callback)
+{
+    processCallback = std::move(callback);
+
+    int err = snd_pcm_prepare(pcm);
+    if (err < 0)
+    {
+        errorMessage = "ALSA " + deviceName + ": cannot prepare: " + snd_strerror(err);
+        return false;
+    }
+
+    // Back once the thread knows whether it got its realtime priority
+    std::promise<int> scheduled;
+    auto priority = scheduled.get_future();
+    running = true;
+    processThread = std::thread([this, &scheduled] { run(scheduled); });
+    realtimePriority = priority.get();
+    return true;
+}
+
+void AlsaBackend::stop()
+{
+    running = false;
+    if (processThread.joinable())
+        processThread.join();
+
+    if (pcm)
+        snd_pcm_drop(pcm);
+}
+
+void AlsaBackend::convertToArea(const snd_pcm_channel_area_t* areas, snd_pcm_uframes_t offset,
+                                uint32_t sourceFrame, uint32_t numFrames)
+{
+    for (uint32_t ch = 0; ch < numChannels; ++ch)
+    {
+        const float* in = channelData[ch].data() + sourceFrame;
+        auto* out = (uint8_t*)areas[ch].addr + (areas[ch].first + offset * areas[ch].step) / 8;
+        size_t stride = areas[ch].step / 8;
+
+        // 24 significant bits - all a float carries - so full scale can't overflow
+        switch (format)
+        {
+            case SND_PCM_FORMAT_S32_LE:
+                convertChannel(in, out, stride, numFrames, 8388607.0f,
+                               [] (uint8_t* dst, int32_t s) { s *= 256; std::memcpy(dst, &s, 4); });
+                break;
+
+            case SND_PCM_FORMAT_S24_3LE:
+                convertChannel(in, out, stride, numFrames, 8388607.0f,
+                               [] (uint8_t* dst, int32_t s) { std::memcpy(dst, &s, 3); });
+                break;
+
+            default:
+                convertChannel(in, out, stride, numFrames, 32767.0f,
+                               [] (uint8_t* dst, int32_t s) { auto s16 = (int16_t)s; std::memcpy(dst, &s16, 2); });
+                break;
+        }
+    }
+}
+
+// Hands one rendered period to the device, waiting for room as needed.
+// Returns 0, or the ALSA error it couldn't recover from.
+int AlsaBackend::writePeriod()
+{
+    uint32_t done = 0;
+
+    while (done < periodFrames && running)
+    {
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(pcm);
+        if (avail < 0)
+        {
+            if (avail == -EPIPE)
+                xruns.fetch_add(1, std::memory_order_relaxed);
+
+            // Underrun or suspend: re-prepare and refill from the rest of this period
+            if (snd_pcm_recover(pcm, (int)avail, 1) < 0)
+                return (int)avail;
+            continue;
+        }
+
+        if ((uint32_t)avail < periodFrames - done)
+        {
+            // Buffer full before the first start - kick the stream off, then sleep until a period drains
+            if (snd_pcm_state(pcm) == SND_PCM_STATE_PREPARED)
+                snd_pcm_start(pcm);
+            snd_pcm_wait(pcm, 1000);
+            continue;
+        }
+
+        const snd_pcm_channel_area_t* areas = nullptr;
+        snd_pcm_uframes_t offset = 0;
+        snd_pcm_uframes_t frames = periodFrames - done;
+
+        int err = snd_pcm_mmap_begin(pcm, &areas, &offset, &frames);
+        if (err < 0)
+        {
+            if (snd_pcm_recover(pcm, err, 1) < 0)
+                return err;
+            continue;
+        }
+
+        convertToArea(areas, offset, done, (uint32_t)frames);
+
+        snd_pcm_sframes_t committed = snd_pcm_mmap_commit(pcm, offset, frames);
+        if (committed < 0 || (snd_pcm_uframes_t)committed != frames)
+        {
+            if (committed == -EPIPE)
+                xruns.fetch_add(1, std::memory_order_relaxed);
+
+            int commitError = committed < 0 ? (int)committed : -EPIPE;
+            if (snd_pcm_recover(pcm, commitError, 1) < 0)
+                return commitError;
+            continue;
+        }
+
+        done += (uint32_t)frames;
+    }
+
+    return 0;
+}
+
+void AlsaBackend::run(std::promise<int>& scheduled)
+{
+    // Without the privilege it just runs at normal priority
+    sched_param param {};
+    param.sched_priority = threadPriority;
+    int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (err != 0)
+        RT_LOG_WARNING("ALSA thread not realtime (SCHED_FIFO %d refused: %s)", threadPriority, strerror(err));
+    scheduled.set_value(err == 0 ? threadPriority : 0);
+
+    RealtimeSetup::prefaultStack();
+
+    AudioProcessBlock block;
+    block.numFrames = periodFrames;
+    block.output = choc::buffer::createChannelArrayView(channelPointers.data(),
+                                                        (choc::buffer::ChannelCount)channelPointers.size(),
+                                                        (choc::buffer::FrameCount)periodFrames);
+
+    while (running)
+    {
+        processCallback(block);
+
+        // Nothing left to play into - stop, and let the control thread decide what next
+        if (int err = writePeriod(); err < 0)
+        {
+            running = false;
+            reportFailure("ALSA " + deviceName + ": device lost: " + snd_strerror(err));
+        }
+    }
+}
@@ -0,0 +1,12 @@
+#include "../include/AudioBackend.h"
+#include "../include/AlsaBackend.h"
+#include "../include/JackBackend.h"
+#include "../include/NullBackend.h"
+
+std::unique_ptr<AudioBackend> AudioBackend::create(const std::string& name)
+{
+    if (name == "jack") return std::make_unique<JackBackend>();
+    if (name == "alsa") return std::make_unique<AlsaBackend>();
+    if (name == "null") return std::make_unique<NullBackend>();
+    return {};
+}
@@ -0,0 +1,189 @@
+#include "../include/AudioReader.h"
+#include "choc/audio/choc_AudioFileFormat_WAV.h"
+#include <algorithm>
+#include <thread>
+
+uint32_t AudioReader::getBytesPerFrame(const choc::audio::AudioFileProperties& properties)
+{
+    uint32_t bytesPerSample = 4;
+    switch (properties.bitDepth)
+    {
+        case choc::audio::BitDepth::int8:    bytesPerSample = 1; break;
+        case choc::audio::BitDepth::int16:   bytesPerSample = 2; break;
+        case choc::audio::BitDepth::int24:   bytesPerSample = 3; break;
+        case choc::audio::BitDepth::float64: bytesPerSample = 8; break;
+        default: break;
+    }
+    return bytesPerSample * properties.numChannels;
+}
+
+bool FileAudioReader::open(const std::string& filePath, const IoUringStreamBuf::Options& options)
+{
+    try
+    {
+        path = filePath;
+        stream = std::make_shared<IoUringFileStream>();
+        if (!stream->open(path, options))
+        {
+            errorMessage = stream->getBuffer().getErrorMessage();
+            return false;
+        }
+
+        decoder = createDecoder();
+        if (!decoder)
+        {
+            errorMessage = "Unsupported audio file format";
+            return false;
+        }
+
+        properties = decoder->getProperties();
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        errorMessage = "Error loading audio file: " + std::string(e.what());
+        return false;
+    }
+}
+
+std::unique_ptr<choc::audio::AudioFileReader> FileAudioReader::createDecoder()
+{
+    choc::audio::AudioFileFormatList formatList;
+    formatList.addFormat<choc::audio::WAVAudioFileFormat<false>>();
+    return formatList.createReader(stream);
+}
+
+bool FileAudioReader::readFrames(uint64_t frame, const choc::buffer::ChannelArrayView<float>& dest)
+{
+    return decoder->readFrames(frame, dest);
+}
+
+bool FileAudioReader::reopen(const std::string& replicaPath)
+{
+    try
+    {
+        if (!stream->reopen(replicaPath))
+        {
+            errorMessage = stream->getBuffer().getErrorMessage();
+            return false;
+        }
+
+        auto replica = createDecoder();
+        if (!replica)
+        {
+            errorMessage = "Unsupported audio file format: " + replicaPath;
+            return false;
+        }
+
+        // It has to be the same audio, or the frame numbers mean nothing
+        auto replicaProperties = replica->getProperties();
+        if (replicaProperties.sampleRate != properties.sampleRate || replicaProperties.numChannels != properties.numChannels
+            || replicaProperties.numFrames != properties.numFrames || replicaProperties.bitDepth != properties.bitDepth)
+        {
+            errorMessage = "Not the same audio as the file being played: " + replicaPath;
+            return false;
+        }
+
+        decoder = std::move(replica);
+        path = replicaPath;
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        errorMessage = "Error reading " + replicaPath + ": " + e.what();
+        return false;
+    }
+}
+
+MemoryAudioReader::MemoryAudioReader(choc::buffer::ChannelArrayBuffer<float> audio, double sampleRate)
+    : frames(std::move(audio))
+{
+    properties.formatName = "memory";
+    properties.sampleRate = sampleRate;
+    properties.numChannels = frames.getNumChannels();
+    properties.numFrames = frames.getNumFrames();
+    properties.bitDepth = choc::audio::BitDepth::float32;
+}
+
+bool MemoryAudioReader::readFrames(uint64_t frame, const choc::buffer::ChannelArrayView<float>& dest)
+{
+    if (dest.getNumChannels() != properties.numChannels || frame + dest.getNumFrames() > properties.numFrames)
+        return false;
+
+    auto start = static_cast<choc::buffer::FrameCount>(frame);
+    choc::buffer::copy(dest, frames.getView().getFrameRange({ start, start + dest.getNumFrames() }));
+    return true;
+}
+
+bool AudioReaderDecorator::reopen(const std::string& path)
+{
+    if (inner->reopen(path))
+        return true;
+
+    errorMessage = inner->getErrorMessage();
+    return false;
+}
+
+ThrottledAudioReader::ThrottledAudioReader(std::unique_ptr<AudioReader> inner, double bytesPerSecond,
+                                           double accessSeconds, double timeScale)
+    : AudioReaderDecorator(std::move(inner)), bytesPerSecond(bytesPerSecond), accessSeconds(accessSeconds),
+      timeScale(std::max(timeScale, 1e-3))
+{
+}
+
+bool ThrottledAudioReader::readFrames(uint64_t frame, const choc::buffer::ChannelArrayView<float>& dest)
+{
+    // The device is busy with earlier reads until busyUntil; this one queues behind them
+    double bytes = (double)dest.getNumFrames() * getBytesPerFrame(getProperties());
+    double seconds = (accessSeconds + (bytesPerSecond > 0.0 ? bytes / bytesPerSecond : 0.0)) / timeScale;
+
+    auto now = std::chrono::steady_clock::now();
+    busyUntil = std::max(busyUntil, now) + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                               std::chrono::duration<double>(seconds));
+    std::this_thread::sleep_until(busyUntil);
+
+    return inner->readFrames(frame, dest);
+}
+
+FaultInjectingAudioReader::FaultInjectingAudioReader(std::unique_ptr<AudioReader> inner, const Options& options)
+    : AudioReaderDecorator(std::move(inner)), options(options), random(options.seed)
+{
+}
+
+bool FaultInjectingAudioReader::readFrames(uint64_t frame, const choc::buffer::ChannelArrayView<float>& dest)
+{
+    // Every draw happens on every read, so a seed gives the same sequence whatever the options
+    double stallDraw = uniform(random);
+    double stallLength = uniform(random);
+    double errorDraw = uniform(random);
+
+    if (frame + dest.getNumFrames() > options.failFromFrame)
+    {
+        mediaFailed = true;
+        options.failFromFrame = UINT64_MAX;  // Dies once - a replacement works
+    }
+
+    if (stallDraw < options.stallProbability && options.stallSeconds > 0.0)
+    {
+        stalls.fetch_add(1, std::memory_order_relaxed);
+        double seconds = stallLength * options.stallSeconds / std::max(options.timeScale, 1e-3);
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    }
+
+    if (mediaFailed || errorDraw < options.errorProbability)
+    {
+        errors.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    return inner->readFrames(frame, dest);
+}
+
+bool FaultInjectingAudioReader::reopen(const std::string& path)
+{
+    if (!AudioReaderDecorator::reopen(path))
+        return false;
+
+    mediaFailed = false;
+    return true;
+}
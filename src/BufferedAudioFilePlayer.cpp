@@ -1,48 +1,78 @@
 #include "../include/BufferedAudioFilePlayer.h"
-#include "choc/audio/choc_AudioFileFormat_WAV.h"
+#include "../include/RealtimeLogger.h"
 #include <iostream>
-#include <fstream>
 #include <algorithm>
 #include <iomanip>
+#include <cmath>
+#include <thread>
 
-BufferedAudioFilePlayer::BufferedAudioFilePlayer(const std::string& filePath, double outputSampleRate)
-    : filePath(filePath), outputSampleRate(outputSampleRate)
+namespace
 {
-    if (!loadAudioFile())
+    uint64_t steadyNanoseconds()
     {
-        isPlaying = false;
-        return;
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
     }
+}
+
+BufferedAudioFilePlayer::BufferedAudioFilePlayer(const std::string& filePath, double outputSampleRate,
+                                                 const IoUringStreamBuf::Options& readOptions)
+    : outputSampleRate(outputSampleRate)
+{
+    auto file = std::make_unique<FileAudioReader>();
+    if (file->open(filePath, readOptions))
+        reader = std::move(file);
+    else
+        errorMessage = file->getErrorMessage();
+
+    initialise();
+}
+
+BufferedAudioFilePlayer::BufferedAudioFilePlayer(std::unique_ptr<AudioReader> audioReader, double outputSampleRate)
+    : reader(std::move(audioReader)), outputSampleRate(outputSampleRate)
+{
+    if (!reader)
+        errorMessage = "No audio reader";
+
+    initialise();
+}
+
+void BufferedAudioFilePlayer::initialise()
+{
+    // Don't start audio output yet - wait for explicit startPlayback() call
+    isPlaying = false;
+
+    if (!reader || !loadAudioFile())
+        return;
 
-    // Calculate buffer size for output sample rate (interleaved samples)
-    bufferSize = getBufferSizeForSampleRate(outputSampleRate) * numChannels;
-    audioBuffer.reset(bufferSize);
+    sourcePaths.push_back(reader->getPath());
+
+    if (outputSampleRate <= 0.0)
+        outputSampleRate = fileSampleRate;
+
+    allocateBuffer();
 
     std::cout << "BufferedAudioFilePlayer initialized:" << std::endl;
-    std::cout << "  File: " << filePath << std::endl;
+    std::cout << "  File: " << (sourcePaths[0].empty() ? "(not a file)" : sourcePaths[0]) << std::endl;
     std::cout << "  File sample rate: " << fileSampleRate << " Hz" << std::endl;
     std::cout << "  Output sample rate: " << outputSampleRate << " Hz" << std::endl;
     std::cout << "  Channels: " << numChannels << std::endl;
     std::cout << "  Total frames: " << totalFrames << std::endl;
-    std::cout << "  Buffer size: " << bufferSize << " samples (" << (bufferSize / numChannels) << " frames)" << std::endl;
-
-    bool needsResampling = (std::abs(fileSampleRate - outputSampleRate) > 0.1);
-    if (needsResampling)
-    {
-        double ratio = fileSampleRate / outputSampleRate;
-        std::cout << "  Resampling: " << fileSampleRate << " Hz -> " << outputSampleRate
-                  << " Hz (ratio: " << std::fixed << std::setprecision(3) << ratio << ")" << std::endl;
-    }
-    else
-    {
-        std::cout << "  No resampling needed (rates match)" << std::endl;
-    }
-
-    // Don't start audio output yet - wait for explicit startPlayback() call
-    isPlaying = false;
+    std::cout << "  Buffer size: " << getBufferSize() << " samples (" << (getBufferSize() / numChannels) << " frames)" << std::endl;
+    if (auto* readAhead = getReadAhead())
+        std::cout << "  File reads: " << (readAhead->isUsingIoUring() ? "io_uring" : "pread")
+                  << (readAhead->isUsingDirectIO() ? " O_DIRECT" : "") << ", "
+                  << readAhead->getBlocksInFlight() << " x " << readAhead->getBlockBytes() / 1024 << " KiB ahead, "
+                  << chunkFrames << "-frame chunks" << std::endl;
+    printResampling();
 }
 
 BufferedAudioFilePlayer::~BufferedAudioFilePlayer()
+{
+    stopLoading();
+}
+
+void BufferedAudioFilePlayer::stopLoading()
 {
     shouldStopLoading = true;
     backgroundThread.stop();
@@ -50,117 +80,360 @@ BufferedAudioFilePlayer::~BufferedAudioFilePlayer()
 
 bool BufferedAudioFilePlayer::loadAudioFile()
 {
-    try
+    const auto& properties = reader->getProperties();
+    fileSampleRate = properties.sampleRate;
+    numChannels = properties.numChannels;
+    totalFrames = properties.numFrames;
+    bytesPerFileFrame = AudioReader::getBytesPerFrame(properties);
+
+    if (numChannels == 0)
     {
-        fileStream = std::make_shared<std::ifstream>(filePath, std::ios::binary);
-        if (!fileStream || !fileStream->is_open())
-        {
-            errorMessage = "Could not open file: " + filePath;
-            return false;
-        }
+        errorMessage = "Invalid audio file format";
+        return false;
+    }
 
-        choc::audio::AudioFileFormatList formatList;
-        formatList.addFormat<choc::audio::WAVAudioFileFormat<false>>();
+    fileLoaded = true;
+    setChunkFrames(0);
+    std::cout << "Audio file loaded successfully" << std::endl;
+    return true;
+}
 
-        fileReader = formatList.createReader(fileStream);
-        if (!fileReader)
-        {
-            errorMessage = "Unsupported audio file format";
-            return false;
-        }
+void BufferedAudioFilePlayer::setReplicaPaths(const std::vector<std::string>& paths)
+{
+    if (!fileLoaded) return;
 
-        auto properties = fileReader->getProperties();
-        fileSampleRate = properties.sampleRate;
-        numChannels = properties.numChannels;
-        totalFrames = properties.numFrames;
+    sourcePaths.resize(1);
+    for (auto& path : paths)
+        if (!path.empty() && path != sourcePaths[0])
+            sourcePaths.push_back(path);
+}
+
+bool BufferedAudioFilePlayer::failOver(uint64_t resumeFrame)
+{
+    // Everything failed last time - don't hammer dead media on every loader tick
+    auto now = std::chrono::steady_clock::now();
+    if (now < nextFailoverAttempt)
+        return false;
 
-        if (numChannels == 0)
+    double bufferedSeconds = (double)getBufferUsedSlots() / numChannels / outputSampleRate;
+
+    // The others in order, then the same path again - a remounted disk or a file put back
+    uint32_t numSources = (uint32_t)sourcePaths.size();
+    for (uint32_t attempt = 1; attempt <= numSources; ++attempt)
+    {
+        uint32_t source = (activeSource + attempt) % numSources;
+        const auto& path = sourcePaths[source];
+
+        if (!reader->reopen(path))
         {
-            errorMessage = "Invalid audio file format";
-            return false;
+            RT_LOG_WARNING("Replica unavailable: %s", reader->getErrorMessage().c_str());
+            continue;
         }
 
-        fileLoaded = true;
-        std::cout << "Audio file loaded successfully" << std::endl;
+        activeSource = source;
+        sourceFailed = false;
+        stats.activeSource.store(source, std::memory_order_relaxed);
+        stats.failovers.fetch_add(1, std::memory_order_relaxed);
+        RT_LOG_WARNING("Reading from %s from frame %llu (%.2fs buffered)",
+                       path.c_str(), (unsigned long long)resumeFrame, bufferedSeconds);
         return true;
     }
-    catch (const std::exception& e)
+
+    // The callback plays out what's buffered meanwhile (then conceals the gap)
+    nextFailoverAttempt = now + failoverRetryInterval;
+    RT_LOG_ERROR("No readable source for the audio file (%.2fs buffered) - retrying", bufferedSeconds);
+    return false;
+}
+
+void BufferedAudioFilePlayer::allocateBuffer()
+{
+    // Sized for the starting depth (interleaved samples); resizeBuffer() follows it from there
+    double startSeconds = std::clamp(defaultBufferSeconds, bufferMinSeconds, bufferMaxSeconds);
+    uint32_t depth = static_cast<uint32_t>(startSeconds * outputSampleRate) * numChannels;
+    bufferDepth.store(depth, std::memory_order_relaxed);
+    readWindow.reset();
+
+    drainingBuffer.reset();
+    fillingBuffer = std::make_unique<SampleFifo>();
+    fillingBuffer->reset(depth);
+    bufferSize.store(depth, std::memory_order_relaxed);
+    writeBuffer.store(fillingBuffer.get(), std::memory_order_release);
+    readBuffer.store(fillingBuffer.get(), std::memory_order_release);
+    pushedCount = poppedCount = 0;
+    samplesPushed.store(0, std::memory_order_release);
+    samplesPopped.store(0, std::memory_order_release);
+    frameScratch.assign(numChannels, 0.0f);
+
+    // Loader chunks are 1024+ frames; leave plenty of room for short ones at the end of
+    // the file. Tags are small, so these are sized for the deepest the FIFO may go.
+    positionTagCapacity = static_cast<uint32_t>(bufferMaxSeconds * outputSampleRate) / 256 + 64;
+    fileReadPosition = 0;
+    resetPositionMap(0);
+
+    transportRampStep = (float)(1.0 / std::max(transportRampSeconds * outputSampleRate, 1.0));
+}
+
+void BufferedAudioFilePlayer::setBufferLimits(double minSeconds, double maxSeconds)
+{
+    if (!fileLoaded) return;
+
+    bufferMinSeconds = std::max(minSeconds, 0.1);
+    bufferMaxSeconds = std::max(maxSeconds, bufferMinSeconds);
+    allocateBuffer();
+
+    std::cout << "  Buffer depth: " << std::fixed << std::setprecision(1) << getBufferDepthSeconds() << "s, adapting within "
+              << bufferMinSeconds << "-" << bufferMaxSeconds << "s (" << getBufferSize() << " samples allocated)" << std::endl;
+}
+
+uint32_t BufferedAudioFilePlayer::getBufferUsedSlots() const
+{
+    // Popped first: a pop counted after its push was loaded would read as negative
+    uint64_t popped = samplesPopped.load(std::memory_order_acquire);
+    uint64_t pushed = samplesPushed.load(std::memory_order_acquire);
+    return pushed > popped ? (uint32_t)(pushed - popped) : 0;
+}
+
+// Loader thread. Swaps in a FIFO sized to the current depth once it has outgrown
+// the allocated one, or fallen to under half of it. The callback carries on with
+// the old FIFO until it is empty and then moves over; the old one is freed here
+// on a later tick. While that is under way the depth is capped at the new size.
+void BufferedAudioFilePlayer::resizeBuffer()
+{
+    if (drainingBuffer)
     {
-        errorMessage = "Error loading audio file: " + std::string(e.what());
-        return false;
+        if (readBuffer.load(std::memory_order_acquire) == drainingBuffer.get())
+            return;
+
+        drainingBuffer.reset();
     }
+
+    uint32_t depth = getBufferDepth();
+    uint32_t capacity = getBufferSize();
+    if (depth <= capacity && depth * bufferShrinkRatio >= capacity)
+        return;
+
+    // Touched before publishing, so the callback never takes a page fault on it
+    auto resized = std::make_unique<SampleFifo>();
+    prefaultFifo(*resized, depth);
+
+    drainingBuffer = std::move(fillingBuffer);
+    fillingBuffer = std::move(resized);
+    bufferSize.store(depth, std::memory_order_relaxed);
+    writeBuffer.store(fillingBuffer.get(), std::memory_order_release);
+
+    RT_LOG_INFO("Buffer reallocated: %u -> %u samples", capacity, depth);
 }
 
-uint32_t BufferedAudioFilePlayer::getBufferSizeForSampleRate(double sampleRate) const
+// Both ends of the FIFO belong to the calling thread (no callback, or it is parked)
+void BufferedAudioFilePlayer::emptyBuffer()
 {
-    return static_cast<uint32_t>(bufferSizeSeconds * sampleRate);
+    if (drainingBuffer)
+    {
+        readBuffer.store(fillingBuffer.get(), std::memory_order_release);
+        drainingBuffer.reset();
+    }
+
+    fillingBuffer->reset(getBufferSize());
+    pushedCount = samplesPopped.load(std::memory_order_acquire);
+    samplesPushed.store(pushedCount, std::memory_order_release);
+}
+
+bool BufferedAudioFilePlayer::pushSample(float sample)
+{
+    if (!fillingBuffer->push(sample))
+        return false;
+
+    samplesPushed.store(++pushedCount, std::memory_order_release);
+    return true;
+}
+
+void BufferedAudioFilePlayer::printResampling() const
+{
+    bool needsResampling = (std::abs(fileSampleRate - outputSampleRate) > 0.1);
+    if (needsResampling)
+    {
+        double ratio = fileSampleRate / outputSampleRate;
+        std::cout << "  Resampling: " << fileSampleRate << " Hz -> " << outputSampleRate
+                  << " Hz (ratio: " << std::fixed << std::setprecision(3) << ratio << ")" << std::endl;
+    }
+    else
+    {
+        std::cout << "  No resampling needed (rates match)" << std::endl;
+    }
 }
 
 void BufferedAudioFilePlayer::setOutputSampleRate(double rate)
 {
     outputSampleRate = rate;
-    // Recalculate buffer size for the new rate
-    bufferSize = getBufferSizeForSampleRate(outputSampleRate) * numChannels;
-    audioBuffer.reset(bufferSize);
+    // Recalculate buffer size for the new rate - anything prefilled at the old rate is dropped
+    allocateBuffer();
+    printResampling();
 }
 
-void BufferedAudioFilePlayer::startPlayback()
+uint32_t BufferedAudioFilePlayer::getFillTarget(double seconds) const
+{
+    uint32_t targetFill = getBufferDepth() * 9/10; // Never more than 90%
+    if (seconds >= 0.0)
+        targetFill = std::min(targetFill, (uint32_t)(seconds * outputSampleRate) * numChannels);
+
+    return std::max(targetFill, 1u);
+}
+
+void BufferedAudioFilePlayer::prefill(double seconds)
 {
     if (!fileLoaded) return;
 
-    // Pre-fill buffer for clean startup
-    std::cout << "Pre-filling buffer..." << std::endl;
+    applyPendingSeek(false);  // No callback yet - this thread owns both ends of the FIFO
+    uint32_t targetFill = getFillTarget(seconds);
 
-    // Fill buffer more aggressively at startup
-    uint32_t targetFill = bufferSize * 9/10; // Fill to 90% before starting
-    while (audioBuffer.getUsedSlots() < targetFill)
+    // A read that only wraps the file pushes nothing - give up after a few in a row
+    int stalledReads = 0;
+    while (getBufferUsedSlots() < targetFill && stalledReads < 3)
     {
+        uint32_t before = getBufferUsedSlots();
         fillBufferFromFile();
-
-        // If we can't fill more, break to avoid infinite loop
-        static uint32_t lastFillLevel = 0;
-        uint32_t currentFill = audioBuffer.getUsedSlots();
-        if (currentFill == lastFillLevel)
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
-            static int stuckCount = 0;
-            if (++stuckCount > 10) break; // Give up after 50ms of no progress
-        }
-        else
-        {
-            lastFillLevel = currentFill;
-        }
+        stalledReads = (getBufferUsedSlots() == before) ? stalledReads + 1 : 0;
     }
+}
+
+void BufferedAudioFilePlayer::startPlayback(bool useLoaderThread, double prefillSeconds)
+{
+    if (!fileLoaded) return;
+
+    // Pre-fill buffer for clean startup
+    std::cout << "Pre-filling buffer..." << std::endl;
+    prefill(prefillSeconds);
 
-    double fillPercentage = (double)audioBuffer.getUsedSlots() / bufferSize * 100.0;
-    std::cout << "Initial buffer fill: " << audioBuffer.getUsedSlots()
+    double fillPercentage = (double)getBufferUsedSlots() / getBufferDepth() * 100.0;
+    std::cout << "Initial buffer fill: " << getBufferUsedSlots()
               << " samples (" << std::fixed << std::setprecision(1) << fillPercentage << "%)" << std::endl;
 
     // Start background loading thread
-    backgroundThread.start(10, [this] { backgroundLoadingTask(); });
+    if (useLoaderThread)
+        backgroundThread.start(10, [this] { backgroundLoadingTask(); });
 
     // Now ready to play - enable audio output
     isPlaying = true;
     std::cout << "Ready for audio playback!" << std::endl;
 }
 
+void BufferedAudioFilePlayer::fillBuffer()
+{
+    if (!fileLoaded)
+        return;
+
+    // Single-threaded - this thread owns both ends of the FIFO. Still, a seek while
+    // playing waits for processBlock() to fade out and park, as it does live, so a
+    // render seeks the way the speakers would hear it.
+    if (transportGain <= 0.0f || seekParked.load(std::memory_order_acquire) == seekRequested.load(std::memory_order_acquire))
+        applyPendingSeek(false);
+
+    // Read chunks until the FIFO is full. A call that only wraps the file to the
+    // start pushes nothing, so give up after two calls in a row without progress.
+    int stalledReads = 0;
+    while (stalledReads < 2)
+    {
+        uint32_t before = getBufferUsedSlots();
+        fillBufferFromFile();
+        stalledReads = (getBufferUsedSlots() == before) ? stalledReads + 1 : 0;
+    }
+}
+
+void BufferedAudioFilePlayer::prefaultFifo(SampleFifo& fifo, uint32_t capacity)
+{
+    // The FIFO doesn't expose its storage, so write through it once and start over
+    fifo.reset(capacity);
+    for (uint32_t i = 0; i < capacity; ++i)
+        if (!fifo.push(0.0f))
+            break;
+
+    fifo.reset(capacity);
+}
+
+void BufferedAudioFilePlayer::prefaultBuffers()
+{
+    if (!fileLoaded)
+        return;
+
+    emptyBuffer();
+    prefaultFifo(*fillingBuffer, getBufferSize());
+
+    // The loader's decode scratch, grown now to the largest chunk it will read
+    double fileFramesPerOutputFrame = std::max(fileSampleRate / outputSampleRate, 1.0);
+    getDecodeView((uint32_t)(chunkFrames * fileFramesPerOutputFrame) + 2).clear();
+}
+
 void BufferedAudioFilePlayer::backgroundLoadingTask()
 {
+    if (!loaderThreadStarted)
+    {
+        loaderThreadStarted = true;
+        if (onLoaderThreadStart) onLoaderThreadStart();
+    }
+
     if (shouldStopLoading || !fileLoaded)
         return;
 
-    // Keep buffer filled
-    if (audioBuffer.getFreeSlots() > numChannels * 512) // If we have space for 512+ frames
+    // A seek goes ahead of streaming
+    if (!applyPendingSeek(true))
+        return;
+
+    resizeBuffer();
+
+    // Keep buffer filled - and while it's under half full (after a short startup
+    // prefill or a seek) keep reading instead of waiting for the next tick. A seek
+    // arriving meanwhile cuts the refill short.
+    do
     {
+        // Up to the current depth; after it shrinks, the excess drains away by itself
+        uint32_t depth = getBufferDepth();
+        if (getBufferUsedSlots() + numChannels * chunkFrames > depth) // Need space for a whole chunk
+            break;
+
+        uint32_t before = getBufferUsedSlots();
         fillBufferFromFile();
+        if (getBufferUsedSlots() == before)
+            break;
+    }
+    while (getBufferUsedSlots() < getBufferDepth() / 2 && !shouldStopLoading && !isSeekPending());
+
+    if (isSeekPending())
+    {
+        backgroundThread.trigger();  // Run again straight away rather than on the next tick
+        return;
+    }
+
+    uint32_t threshold = bufferedThreshold.load(std::memory_order_acquire);
+    if (threshold != 0 && getBufferUsedSlots() >= threshold
+        && bufferedThreshold.compare_exchange_strong(threshold, 0, std::memory_order_acq_rel))
+    {
+        if (onBuffered) onBuffered();
     }
 }
 
-void BufferedAudioFilePlayer::fillBufferFromFile()
+void BufferedAudioFilePlayer::setChunkFrames(uint32_t frames)
+{
+    if (!fileLoaded) return;
+
+    // Auto: about one read-ahead block's worth, so each chunk is mostly one copy out of it
+    if (frames == 0)
+        frames = getReadAhead() ? getReadAhead()->getBlockBytes() / std::max(bytesPerFileFrame, 1u) : defaultChunkFrames;
+
+    chunkFrames = std::clamp(frames, minChunkFrames, maxChunkFrames);
+}
+
+choc::buffer::ChannelArrayView<float> BufferedAudioFilePlayer::getDecodeView(uint32_t frames)
 {
-    static constexpr uint32_t chunkFrames = 1024; // Read 1024 frames at a time
+    // Grows once to the largest chunk, instead of an allocation per chunk
+    if (decodeBuffer.getNumFrames() < frames || decodeBuffer.getNumChannels() != numChannels)
+        decodeBuffer.resize(choc::buffer::Size::create(numChannels, frames));
+
+    return decodeBuffer.getView().getStart(frames);
+}
 
-    uint32_t freeSlots = audioBuffer.getFreeSlots();
+void BufferedAudioFilePlayer::fillBufferFromFile()
+{
+    uint32_t freeSlots = fillingBuffer->getFreeSlots();
     uint32_t freeFrames = freeSlots / numChannels;
 
     if (freeFrames < chunkFrames)
@@ -169,12 +442,18 @@ void BufferedAudioFilePlayer::fillBufferFromFile()
     uint32_t framesToRead = std::min(chunkFrames, freeFrames);
     uint64_t currentFilePos = fileReadPosition.load();
 
+    // After a read failure: carry on from the same frame on the next replica that opens
+    if (sourceFailed && !failOver(currentFilePos))
+        return;
+
     // Handle file looping
     if (currentFilePos >= totalFrames)
     {
         currentFilePos = 0;
         fileReadPosition = 0;
         loopPlaybackDetected.store(true, std::memory_order_release);
+        stats.loops.fetch_add(1, std::memory_order_relaxed);
+        if (onLoopDetected) onLoopDetected();
     }
 
     try
@@ -189,9 +468,13 @@ void BufferedAudioFilePlayer::fillBufferFromFile()
             currentFilePos = 0;
             fileReadPosition = 0;
             loopPlaybackDetected.store(true, std::memory_order_release);
+            stats.loops.fetch_add(1, std::memory_order_relaxed);
+            if (onLoopDetected) onLoopDetected();
             return;
         }
 
+        auto readStarted = std::chrono::steady_clock::now();
+
         // Check if we need resampling
         bool needsResampling = (std::abs(fileSampleRate - outputSampleRate) > 0.1);
 
@@ -202,16 +485,23 @@ void BufferedAudioFilePlayer::fillBufferFromFile()
             uint32_t fileFramesToRead = static_cast<uint32_t>(actualFramesToRead * sampleRateRatio) + 2;
             fileFramesToRead = std::min(fileFramesToRead, availableFrames);
 
-            // Create buffer for file data
-            choc::buffer::ChannelArrayBuffer<float> fileBuffer(
-                choc::buffer::Size::create(numChannels, fileFramesToRead));
+            // Near the end of the file the source runs out first - only output frames
+            // with a source frame are pushed, and the position tag must say so
+            uint32_t producibleFrames = (uint32_t)std::ceil(fileFramesToRead / sampleRateRatio);
+            while (producibleFrames > 0 && (uint32_t)((producibleFrames - 1) * sampleRateRatio) >= fileFramesToRead)
+                --producibleFrames;
+            while (producibleFrames < actualFramesToRead && (uint32_t)(producibleFrames * sampleRateRatio) < fileFramesToRead)
+                ++producibleFrames;
+            actualFramesToRead = std::min(actualFramesToRead, producibleFrames);
 
             // Read from file
-            auto fileView = fileBuffer.getView().getStart(fileFramesToRead);
-            bool success = fileReader->readFrames(currentFilePos, fileView);
+            auto fileView = getDecodeView(fileFramesToRead);
+            bool success = reader->readFrames(currentFilePos, fileView);
 
             if (success)
             {
+                positionTags.push({ currentFilePos, actualFramesToRead, sampleRateRatio });
+
                 // Cubic interpolation - better quality than linear, still efficient
                 for (uint32_t outFrame = 0; outFrame < actualFramesToRead; ++outFrame)
                 {
@@ -238,9 +528,10 @@ void BufferedAudioFilePlayer::fillBufferFromFile()
                             float t = static_cast<float>(fraction);
                             float interpolated = a0 * t * t * t + a1 * t * t + a2 * t + a3;
 
-                            if (!audioBuffer.push(interpolated))
+                            if (!pushSample(interpolated))
                             {
                                 fileReadPosition = currentFilePos + sourceFrame;
+                                recordRead(fileFramesToRead, readStarted);
                                 return;
                             }
                         }
@@ -254,9 +545,10 @@ void BufferedAudioFilePlayer::fillBufferFromFile()
                             float sample2 = fileView.getSample(channel, sourceFrame + 1);
                             float interpolated = sample1 + fraction * (sample2 - sample1);
 
-                            if (!audioBuffer.push(interpolated))
+                            if (!pushSample(interpolated))
                             {
                                 fileReadPosition = currentFilePos + sourceFrame;
+                                recordRead(fileFramesToRead, readStarted);
                                 return;
                             }
                         }
@@ -267,35 +559,40 @@ void BufferedAudioFilePlayer::fillBufferFromFile()
                         for (uint32_t channel = 0; channel < numChannels; ++channel)
                         {
                             float sample = fileView.getSample(channel, sourceFrame);
-                            if (!audioBuffer.push(sample))
+                            if (!pushSample(sample))
                             {
                                 fileReadPosition = currentFilePos + sourceFrame;
+                                recordRead(fileFramesToRead, readStarted);
                                 return;
                             }
                         }
                     }
                 }
 
-                // Update file position
-                fileReadPosition = currentFilePos + fileFramesToRead;
+                // Advance by what the output frames covered - the extra frames read
+                // past that were only lookahead for the interpolator
+                uint32_t fileFramesConsumed = std::min((uint32_t)std::lround(actualFramesToRead * sampleRateRatio), availableFrames);
+                fileReadPosition = currentFilePos + fileFramesConsumed;
+                recordRead(fileFramesToRead, readStarted);
             }
             else
             {
-                std::cerr << "Failed to read from audio file during resampling" << std::endl;
+                stats.readErrors.fetch_add(1, std::memory_order_relaxed);
+                sourceFailed = true;
+                RT_LOG_ERROR("Failed to read from audio file during resampling (frame %llu)",
+                             (unsigned long long)currentFilePos);
             }
         }
         else
         {
-            // No resampling needed - direct copy
-            choc::buffer::ChannelArrayBuffer<float> readBuffer(
-                choc::buffer::Size::create(numChannels, actualFramesToRead));
-
-            // Read frames from file
-            auto readView = readBuffer.getView().getStart(actualFramesToRead);
-            bool success = fileReader->readFrames(currentFilePos, readView);
+            // No resampling needed - direct copy. Read frames from file
+            auto readView = getDecodeView(actualFramesToRead);
+            bool success = reader->readFrames(currentFilePos, readView);
 
             if (success)
             {
+                positionTags.push({ currentFilePos, actualFramesToRead, 1.0 });
+
                 // Push samples to FIFO buffer in interleaved format
                 for (uint32_t frame = 0; frame < actualFramesToRead; ++frame)
                 {
@@ -304,9 +601,10 @@ void BufferedAudioFilePlayer::fillBufferFromFile()
                         float sample = readView.getSample(channel, frame);
 
                         // If buffer is full, we're done for now
-                        if (!audioBuffer.push(sample))
+                        if (!pushSample(sample))
                         {
                             fileReadPosition = currentFilePos + frame;
+                            recordRead(actualFramesToRead, readStarted);
                             return;
                         }
                     }
@@ -314,16 +612,70 @@ void BufferedAudioFilePlayer::fillBufferFromFile()
 
                 // Update file position
                 fileReadPosition = currentFilePos + actualFramesToRead;
+                recordRead(actualFramesToRead, readStarted);
             }
             else
             {
-                std::cerr << "Failed to read from audio file" << std::endl;
+                stats.readErrors.fetch_add(1, std::memory_order_relaxed);
+                sourceFailed = true;
+                RT_LOG_ERROR("Failed to read from audio file (frame %llu)", (unsigned long long)currentFilePos);
             }
         }
     }
     catch (const std::exception& e)
     {
-        std::cerr << "Error reading from audio file: " << e.what() << std::endl;
+        stats.readErrors.fetch_add(1, std::memory_order_relaxed);
+        sourceFailed = true;
+        RT_LOG_ERROR("Error reading from audio file: %s", e.what());
+    }
+}
+
+void BufferedAudioFilePlayer::recordRead(uint64_t fileFrames, std::chrono::steady_clock::time_point started)
+{
+    auto elapsed = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+    stats.refillLatency.observe(elapsed);
+    adaptBufferDepth(elapsed);
+    stats.framesRead.fetch_add(fileFrames, std::memory_order_relaxed);
+    stats.bytesRead.fetch_add(fileFrames * bytesPerFileFrame, std::memory_order_relaxed);
+}
+
+uint32_t BufferedAudioFilePlayer::getDepthForStall(uint64_t readNanoseconds) const
+{
+    double seconds = stallMarginFactor * (double)readNanoseconds * 1e-9 + depthHeadroomSeconds;
+    seconds = std::clamp(seconds, bufferMinSeconds, bufferMaxSeconds);
+    return static_cast<uint32_t>(seconds * outputSampleRate) * numChannels;
+}
+
+// Grows straight away for a read the current depth couldn't ride out; shrinks a
+// quarter at a time, once a whole window of reads says it can
+void BufferedAudioFilePlayer::adaptBufferDepth(uint64_t readNanoseconds)
+{
+    if (bufferMaxSeconds <= bufferMinSeconds)
+        return;
+
+    readWindow.observe(readNanoseconds);
+    uint32_t depth = getBufferDepth();
+
+    uint32_t needed = getDepthForStall(readNanoseconds);
+    if (needed > depth)
+    {
+        bufferDepth.store(needed, std::memory_order_relaxed);
+        RT_LOG_WARNING("Read took %.1f ms - buffer depth up to %.1fs",
+                       readNanoseconds * 1e-6, getBufferDepthSeconds());
+        return;
+    }
+
+    if (readWindow.getCount() < depthWindowReads)
+        return;
+
+    uint64_t p999 = readWindow.getPercentile(0.999);
+    readWindow.reset();
+
+    uint32_t wanted = std::max(getDepthForStall(p999), depth * 3 / 4);
+    if (wanted < depth)
+    {
+        bufferDepth.store(wanted, std::memory_order_relaxed);
+        RT_LOG_INFO("Reads steady (p99.9 %.1f ms) - buffer depth down to %.1fs", p999 * 1e-6, getBufferDepthSeconds());
     }
 }
 
@@ -332,83 +684,250 @@ void BufferedAudioFilePlayer::processBlock(choc::buffer::ChannelArrayView<float>
     // Always clear output first to avoid clicks/pops
     output.clear();
 
-    if (!isPlaying || !fileLoaded)
+    // A seek is waiting for the loader - once any fade-out is done, keep off the FIFO
+    // until it has refilled. What comes after fades in from silence.
+    uint32_t seekRequest = seekRequested.load(std::memory_order_acquire);
+    bool seekPending = seekRequest != seekApplied.load(std::memory_order_acquire);
+    if (seekPending && transportGain <= 0.0f)
     {
+        seekParked.store(seekRequest, std::memory_order_release);
+        seekAwaitingAudio = true;
+        return;
+    }
+
+    // After a pause the output fades out over the ramp, still reading the FIFO
+    bool playing = isPlaying.load(std::memory_order_relaxed) && !seekPending;
+    if (!fileLoaded || (!playing && transportGain <= 0.0f))
+    {
+        transportGain = 0.0f;
         return;
     }
 
     auto numFrames = output.getNumFrames();
     auto numOutputChannels = output.getNumChannels();
+    uint32_t framesWanted = playing ? numFrames
+                                    : std::min<uint32_t>(numFrames, (uint32_t)std::ceil(transportGain / transportRampStep));
+
+    // After a resize the old FIFO plays out first, then the new one the loader has been filling
+    SampleFifo* fifo = readBuffer.load(std::memory_order_acquire);
+    SampleFifo* next = writeBuffer.load(std::memory_order_acquire);
+
+    // Track buffer health for telemetry
+    uint32_t usedSlots = fifo->getUsedSlots() + (next != fifo ? next->getUsedSlots() : 0);
+    stats.fillSampleSum.fetch_add(usedSlots, std::memory_order_relaxed);
+    stats.fillObservations.fetch_add(1, std::memory_order_relaxed);
+    uint32_t lowest = stats.minFillSamples.load(std::memory_order_relaxed);
+    while (usedSlots < lowest && !stats.minFillSamples.compare_exchange_weak(lowest, usedSlots, std::memory_order_relaxed)) {}
+
+    // Render whatever is there; only the shortfall at the end of the block is silent
+    uint32_t samplesNeeded = framesWanted * numChannels;
+    uint32_t framesToRender = std::min<uint32_t>(framesWanted, usedSlots / numChannels);
+    uint32_t missingFrames = framesWanted - framesToRender;
+    bool recovering = inUnderrun;  // The last block ended in a gap
+
+    if (missingFrames > 0)
+    {
+        stats.underruns.fetch_add(1, std::memory_order_relaxed);
+        stats.underrunFrames.fetch_add(missingFrames, std::memory_order_relaxed);
 
-    // Check if we have enough samples in buffer
-    uint32_t samplesNeeded = numFrames * numChannels;
-    if (audioBuffer.getUsedSlots() < samplesNeeded)
+        // Logged once per episode; the counters above have the totals
+        if (!inUnderrun)
+        {
+            inUnderrun = true;
+            RT_LOG_WARNING("Buffer underrun! Need %u samples, have %u", samplesNeeded, usedSlots);
+        }
+    }
+    else if (inUnderrun)
     {
-        // Buffer underrun - output silence (already cleared)
-        // NOTE: Avoid I/O in audio callback - uncomment for debugging only
-        // static int underrunCount = 0;
-        // if (underrunCount++ % 100 == 0)
-        // {
-        //     std::cout << "Buffer underrun! Need " << samplesNeeded << " samples, have "
-        //              << audioBuffer.getUsedSlots() << std::endl;
-        // }
-        return;
+        inUnderrun = false;
+        RT_LOG_INFO("Buffer recovered (%u samples)", usedSlots);
     }
 
+    // Short fades into and out of a gap, so a stall is a dip rather than a click
+    uint32_t fadeInFrames = recovering ? std::min(concealFadeFrames, framesToRender) : 0;
+    uint32_t fadeOutFrames = missingFrames > 0 ? std::min(concealFadeFrames, framesToRender) : 0;
+
     // Read samples from buffer and convert from interleaved to channel format
     float gain = currentGain.load(std::memory_order_relaxed);
 
-    for (uint32_t frame = 0; frame < numFrames; ++frame)
+    for (uint32_t frame = 0; frame < framesToRender; ++frame)
     {
         // Read one frame of interleaved samples
-        float frameSamples[8] = {0}; // Support up to 8 channels
+        float* frameSamples = frameScratch.data();
 
-        for (uint32_t channel = 0; channel < numChannels && channel < 8; ++channel)
+        if (fifo != next && fifo->getUsedSlots() < numChannels)
         {
-            audioBuffer.pop(frameSamples[channel]);
+            fifo = next;
+            readBuffer.store(fifo, std::memory_order_release);  // The loader may free the old one now
         }
 
+        for (uint32_t channel = 0; channel < numChannels; ++channel)
+        {
+            fifo->pop(frameSamples[channel]);
+        }
+
+        float frameGain = gain;
+        if (frame < fadeInFrames)
+            frameGain *= (float)(frame + 1) / (float)(fadeInFrames + 1);
+        if (framesToRender - frame <= fadeOutFrames)
+            frameGain *= (float)(framesToRender - frame) / (float)(fadeOutFrames + 1);
+
+        // Play and pause ramp rather than cut
+        transportGain = playing ? std::min(transportGain + transportRampStep, 1.0f)
+                                : std::max(transportGain - transportRampStep, 0.0f);
+        frameGain *= transportGain;
+
         // Copy to output channels with gain applied
         for (uint32_t channel = 0; channel < numOutputChannels; ++channel)
         {
             uint32_t sourceChannel = std::min(channel, numChannels - 1);
-            float sample = frameSamples[sourceChannel] * gain;
+            float sample = frameSamples[sourceChannel] * frameGain;
             output.getSample(channel, frame) = sample;
         }
     }
 
+    if (framesToRender == 0)
+        return;
+
+    poppedCount += (uint64_t)framesToRender * numChannels;
+    samplesPopped.store(poppedCount, std::memory_order_release);
+
     // Update playback position counter (actual samples sent to output)
-    totalSamplesPlayed.fetch_add(numFrames, std::memory_order_relaxed);
+    totalSamplesPlayed.fetch_add(framesToRender, std::memory_order_relaxed);
+    advancePositionMap(framesToRender);
+
+    if (seekAwaitingAudio)
+    {
+        seekAwaitingAudio = false;
+        uint64_t requestedAt = seekRequestedAt.exchange(0, std::memory_order_relaxed);
+        if (requestedAt != 0)
+            stats.seekLatency.observe(steadyNanoseconds() - requestedAt);
+    }
 }
 
-uint64_t BufferedAudioFilePlayer::skipForward(double seconds)
+void BufferedAudioFilePlayer::resetPositionMap(uint64_t fileFrame)
 {
-    if (!fileLoaded) return getCurrentOutputFrame();
+    positionTags.reset(positionTagCapacity);
+    emittedFileFrame.store(fileFrame, std::memory_order_release);
+    positionMapReset.store(true, std::memory_order_release);
+}
 
-    // Calculate new file position (in file's sample rate)
-    uint64_t framesToSkip = static_cast<uint64_t>(seconds * fileSampleRate);
-    uint64_t currentFilePos = fileReadPosition.load();
-    uint64_t newFilePos = currentFilePos + framesToSkip;
+void BufferedAudioFilePlayer::advancePositionMap(uint32_t numFrames)
+{
+    if (positionMapReset.exchange(false, std::memory_order_acq_rel))
+    {
+        currentTag = {};
+        currentTagFramesUsed = 0;
+    }
 
-    // Handle wrap-around if we skip past the end
+    while (numFrames > 0)
+    {
+        if (currentTagFramesUsed >= currentTag.outputFrames)
+        {
+            PositionTag next;
+            if (!positionTags.pop(next))
+                break;  // Can't happen while tags are pushed before their samples
+
+            currentTag = next;
+            currentTagFramesUsed = 0;
+        }
+
+        uint32_t frames = std::min(numFrames, currentTag.outputFrames - currentTagFramesUsed);
+        currentTagFramesUsed += frames;
+        numFrames -= frames;
+    }
+
+    if (currentTag.outputFrames > 0)
+    {
+        auto fileFrame = currentTag.fileFrame + (uint64_t)(currentTagFramesUsed * currentTag.fileFramesPerOutputFrame);
+        emittedFileFrame.store(fileFrame, std::memory_order_release);
+    }
+}
+
+uint64_t BufferedAudioFilePlayer::getAudibleFileFrame(uint32_t outputLatencyFrames) const
+{
+    if (isSeekPending())
+        return seekTarget.load(std::memory_order_relaxed);
+
+    uint64_t emitted = getEmittedFileFrame();
+    if (!isPlaying || totalFrames == 0)
+        return emitted;
+
+    auto latency = (uint64_t)(outputLatencyFrames * fileSampleRate / outputSampleRate);
+    latency %= totalFrames;
+
+    // Just after a loop the speakers are still playing the end of the file
+    return emitted >= latency ? emitted - latency : emitted + totalFrames - latency;
+}
+
+uint64_t BufferedAudioFilePlayer::getRelativeSeekTarget(double seconds, uint32_t outputLatencyFrames) const
+{
+    if (totalFrames == 0) return 0;
+
+    auto total = (int64_t)totalFrames;
+    int64_t target = ((int64_t)getAudibleFileFrame(outputLatencyFrames) + (int64_t)std::llround(seconds * fileSampleRate)) % total;
+    return (uint64_t)(target < 0 ? target + total : target);
+}
+
+uint64_t BufferedAudioFilePlayer::seekToFrame(uint64_t newFilePos, bool timed)
+{
+    if (!fileLoaded) return getCurrentOutputFrame();
+
+    // Handle wrap-around if we seek past the end
     if (newFilePos >= totalFrames)
     {
         newFilePos = newFilePos % totalFrames;
     }
 
-    // Just update file position atomically - buffer will refill automatically
-    fileReadPosition.store(newFilePos, std::memory_order_release);
+    requestSeek(newFilePos, timed);
+    RT_LOG_INFO("Seek to %.2fs", (double)newFilePos / fileSampleRate);
 
-    // Update playback position to match (convert from file sample rate to output sample rate)
-    double newPositionSeconds = (double)newFilePos / fileSampleRate;
-    uint64_t newOutputFrame = (uint64_t)(newPositionSeconds * outputSampleRate);
-    totalSamplesPlayed.store(newOutputFrame, std::memory_order_release);
+    return (uint64_t)((double)newFilePos / fileSampleRate * outputSampleRate);
+}
+
+void BufferedAudioFilePlayer::requestSeek(uint64_t fileFrame, bool timed)
+{
+    seekTarget.store(fileFrame, std::memory_order_relaxed);
+    seekRequestedAt.store(timed ? steadyNanoseconds() : 0, std::memory_order_relaxed);
+    seekRequested.fetch_add(1, std::memory_order_release);
+    backgroundThread.trigger();
+}
+
+// Returns false if the callback didn't let go of the FIFO in time
+bool BufferedAudioFilePlayer::applyPendingSeek(bool waitForCallback)
+{
+    uint32_t requested = seekRequested.load(std::memory_order_acquire);
+    if (requested == seekApplied.load(std::memory_order_relaxed))
+        return true;
+
+    // The callback parks within a period
+    for (int waited = 0; waitForCallback && seekParked.load(std::memory_order_acquire) != requested; ++waited)
+    {
+        if (waited >= seekParkTimeoutMs || shouldStopLoading)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // A newer request may have replaced the target since - then it's applied now and
+    // the callback stays parked until its own generation is published
+    uint64_t target = seekTarget.load(std::memory_order_relaxed);
 
-    // Clear buffer so we don't play stale audio
-    audioBuffer.reset(bufferSize);
+    emptyBuffer();
+    fileReadPosition.store(target, std::memory_order_release);
+    totalSamplesPlayed.store((uint64_t)((double)target / fileSampleRate * outputSampleRate), std::memory_order_release);
+    resetPositionMap(target);
 
-    std::cout << "Seek to " << std::fixed << std::setprecision(2)
-              << (double)newFilePos / fileSampleRate << "s" << std::endl;
+    // Refill just enough to resume before handing back - the rest streams in as usual
+    uint32_t refillTarget = getFillTarget(seekRefillSeconds);
+    int stalledReads = 0;
+    while (getBufferUsedSlots() < refillTarget && stalledReads < 3)
+    {
+        uint32_t before = getBufferUsedSlots();
+        fillBufferFromFile();
+        stalledReads = (getBufferUsedSlots() == before) ? stalledReads + 1 : 0;
+    }
 
-    return getCurrentOutputFrame();
-}
\ No newline at end of file
+    stats.seeks.fetch_add(1, std::memory_order_relaxed);
+    seekApplied.store(requested, std::memory_order_release);
+    return true;
+}
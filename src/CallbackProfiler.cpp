@@ -0,0 +1,143 @@
+#include "../include/CallbackProfiler.h"
+#include "../include/MetricsServer.h"
+#include <cstdio>
+
+namespace
+{
+    constexpr double reportQuantiles[] = { 0.5, 0.99, 0.999 };
+}
+
+const char* CallbackProfiler::stageName(Stage stage)
+{
+    switch (stage)
+    {
+        case midiStage:     return "midi";
+        case renderStage:   return "render";
+        case timecodeStage: return "timecode";
+        case positionStage: return "position";
+        default:            return "unknown";
+    }
+}
+
+void CallbackProfiler::setBudget(uint32_t frames, double sampleRate)
+{
+    periodFrames.store(frames, std::memory_order_relaxed);
+    budgetNs.store(sampleRate > 0 ? static_cast<uint64_t>(frames * 1e9 / sampleRate) : 0, std::memory_order_relaxed);
+}
+
+void CallbackProfiler::record(const Cycle& cycle)
+{
+    uint64_t total = cycle.mark - cycle.start;
+    cycleTime.observe(total);
+
+    int slowestStage = 0;
+    for (int s = 0; s < numStages; ++s)
+    {
+        if (cycle.stageNs[s] > 0)
+            stageTime[s].observe(cycle.stageNs[s]);
+
+        if (cycle.stageNs[s] > cycle.stageNs[slowestStage])
+            slowestStage = s;
+    }
+
+    uint64_t budget = budgetNs.load(std::memory_order_relaxed);
+    if (budget > 0 && total > budget)
+        overBudget.fetch_add(1, std::memory_order_relaxed);
+
+    // Single writer, so no CAS needed; readers may briefly see the new time with the old stage
+    if (total > worstCycleNs.load(std::memory_order_relaxed))
+    {
+        worstCycleStage.store(slowestStage, std::memory_order_relaxed);
+        worstCycleNs.store(total, std::memory_order_relaxed);
+    }
+}
+
+void CallbackProfiler::writePrometheus(std::string& out) const
+{
+    cycleTime.writePrometheus(out, "player_callback_seconds", "Wall time of each process callback");
+
+    for (int s = 0; s < numStages; ++s)
+    {
+        char labels[32];
+        std::snprintf(labels, sizeof(labels), "stage=\"%s\"", stageName(static_cast<Stage>(s)));
+        stageTime[s].writePrometheus(out, "player_callback_stage_seconds",
+                                     s == 0 ? "Time spent in each callback stage, per cycle it ran in" : nullptr,
+                                     1e-9, labels);
+    }
+
+    double budget = getBudgetSeconds();
+    MetricsServer::writeGauge(out, "player_callback_budget_seconds", "Period budget (buffer size / sample rate)", budget);
+    MetricsServer::writeCounter(out, "player_callback_over_budget_total", "Callbacks that took longer than the period budget",
+                                (double)getOverBudgetCount());
+
+    // Load quantiles precomputed here, so dashboards don't need histogram_quantile() at this resolution
+    char line[256];
+    out += "# HELP player_callback_load_ratio Callback time as a fraction of the period budget\n"
+           "# TYPE player_callback_load_ratio gauge\n";
+    for (double q : reportQuantiles)
+    {
+        double seconds = cycleTime.getPercentile(q) * 1e-9;
+        std::snprintf(line, sizeof(line), "player_callback_load_ratio{quantile=\"%g\"} %.6g\n", q,
+                      budget > 0 ? seconds / budget : 0.0);
+        out += line;
+    }
+    std::snprintf(line, sizeof(line), "player_callback_load_ratio{quantile=\"1\"} %.6g\n",
+                  budget > 0 ? cycleTime.getMax() * 1e-9 / budget : 0.0);
+    out += line;
+
+    std::snprintf(line, sizeof(line),
+                  "# HELP player_callback_worst_stage_info Stage that dominated the slowest callback\n"
+                  "# TYPE player_callback_worst_stage_info gauge\n"
+                  "player_callback_worst_stage_info{stage=\"%s\"} 1\n",
+                  stageName(static_cast<Stage>(worstCycleStage.load(std::memory_order_relaxed))));
+    out += line;
+}
+
+std::string CallbackProfiler::getReport() const
+{
+    std::string report;
+    char line[256];
+
+    uint64_t cycles = cycleTime.getCount();
+    double budgetUs = budgetNs.load(std::memory_order_relaxed) / 1000.0;
+
+    std::snprintf(line, sizeof(line), "Callback profile: %llu cycles, budget %.1f us (%u frames)\n",
+                  static_cast<unsigned long long>(cycles), budgetUs, periodFrames.load(std::memory_order_relaxed));
+    report += line;
+
+    if (cycles == 0)
+        return report;
+
+    std::snprintf(line, sizeof(line), "  %-9s %9s %9s %9s %9s   (us)\n", "stage", "p50", "p99", "p99.9", "max");
+    report += line;
+
+    auto addRow = [&] (const char* name, const LatencyHistogram& h)
+    {
+        if (h.getCount() == 0)
+            return;
+
+        std::snprintf(line, sizeof(line), "  %-9s %9.1f %9.1f %9.1f %9.1f\n", name,
+                      h.getPercentile(0.5) / 1000.0, h.getPercentile(0.99) / 1000.0,
+                      h.getPercentile(0.999) / 1000.0, h.getMax() / 1000.0);
+        report += line;
+    };
+
+    addRow("total", cycleTime);
+    for (int s = 0; s < numStages; ++s)
+        addRow(stageName(static_cast<Stage>(s)), stageTime[s]);
+
+    double worstUs = worstCycleNs.load(std::memory_order_relaxed) / 1000.0;
+    std::snprintf(line, sizeof(line), "  Over budget: %llu cycles; worst %.1f us", static_cast<unsigned long long>(getOverBudgetCount()), worstUs);
+    report += line;
+
+    if (budgetUs > 0)
+    {
+        std::snprintf(line, sizeof(line), " (%.0f%% of budget)", 100.0 * worstUs / budgetUs);
+        report += line;
+    }
+
+    report += ", mostly ";
+    report += stageName(static_cast<Stage>(worstCycleStage.load(std::memory_order_relaxed)));
+    report += "\n";
+    return report;
+}
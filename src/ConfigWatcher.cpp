@@ -0,0 +1,61 @@
+#include "../include/ConfigWatcher.h"
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+ConfigWatcher::~ConfigWatcher()
+{
+    if (inotifyFd >= 0)
+        close(inotifyFd);
+}
+
+bool ConfigWatcher::start(const std::string& filePath)
+{
+    std::filesystem::path path(filePath);
+    fileName = path.filename().string();
+    std::string directory = path.has_parent_path() ? path.parent_path().string() : ".";
+
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0)
+    {
+        errorMessage = std::string("Cannot create inotify instance: ") + strerror(errno);
+        return false;
+    }
+
+    // Finished writes in place, and files renamed into place
+    if (inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        errorMessage = "Cannot watch " + directory + ": " + strerror(errno);
+        close(inotifyFd);
+        inotifyFd = -1;
+        return false;
+    }
+
+    return true;
+}
+
+bool ConfigWatcher::readChanges()
+{
+    alignas(inotify_event) char buffer[4096];
+    bool changed = false;
+
+    for (;;)
+    {
+        ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+
+        for (ssize_t offset = 0; offset < length;)
+        {
+            auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0 && fileName == event->name)
+                changed = true;
+
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+
+    return changed;
+}
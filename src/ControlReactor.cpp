@@ -0,0 +1,197 @@
+#include "../include/ControlReactor.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+
+ControlReactor::ControlReactor()
+{
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0)
+        std::cerr << "Failed to create epoll instance" << std::endl;
+}
+
+ControlReactor::~ControlReactor()
+{
+    for (auto& source : sources)
+        if (source->owned)
+            close(source->fd);
+
+    if (epollFd >= 0)
+        close(epollFd);
+}
+
+ControlReactor::Source* ControlReactor::findSource(int fd) const
+{
+    for (auto& source : sources)
+        if (source->fd == fd)
+            return source.get();
+
+    return nullptr;
+}
+
+ControlReactor::Source* ControlReactor::addSource(int fd, SourceKind kind, bool owned)
+{
+    if (fd < 0)
+        return nullptr;
+
+    auto source = std::make_unique<Source>();
+    source->fd = fd;
+    source->kind = kind;
+    source->owned = owned;
+
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.ptr = source.get();
+
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+        if (owned)
+            close(fd);
+        return nullptr;
+    }
+
+    sources.push_back(std::move(source));
+    return sources.back().get();
+}
+
+int ControlReactor::createNotifier()
+{
+    auto* source = addSource(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), SourceKind::notifier, true);
+    return source ? source->fd : -1;
+}
+
+int ControlReactor::createTimer()
+{
+    auto* source = addSource(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC), SourceKind::timer, true);
+    return source ? source->fd : -1;
+}
+
+void ControlReactor::armTimer(int timerFd, uint32_t delayMs, uint32_t intervalMs)
+{
+    itimerspec spec {};
+    spec.it_value.tv_sec = delayMs / 1000;
+    spec.it_value.tv_nsec = (long)(delayMs % 1000) * 1000000L;
+    spec.it_interval.tv_sec = intervalMs / 1000;
+    spec.it_interval.tv_nsec = (long)(intervalMs % 1000) * 1000000L;
+    timerfd_settime(timerFd, 0, &spec, nullptr);
+}
+
+int ControlReactor::createSignalFd(const sigset_t& signals, std::function<void(int)> handler)
+{
+    auto* source = addSource(signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC), SourceKind::signal, true);
+    if (!source)
+        return -1;
+
+    source->signalHandler = std::move(handler);
+    return source->fd;
+}
+
+bool ControlReactor::onReadable(int fd, Handler handler)
+{
+    auto* source = findSource(fd);
+    if (!source)
+        source = addSource(fd, SourceKind::readable, false);
+
+    if (!source)
+        return false;
+
+    source->handler = std::move(handler);
+    return true;
+}
+
+void ControlReactor::remove(int fd)
+{
+    auto* source = findSource(fd);
+    if (!source)
+        return;
+
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    if (source->owned)
+        close(fd);
+
+    // Events for it may still be in the batch being dispatched - it goes once that's done
+    source->fd = -1;
+    source->removed = true;
+}
+
+void ControlReactor::eraseRemovedSources()
+{
+    sources.erase(std::remove_if(sources.begin(), sources.end(), [] (const auto& source) { return source->removed; }),
+                  sources.end());
+}
+
+void ControlReactor::notify(int notifierFd)
+{
+    if (notifierFd < 0)
+        return;
+
+    uint64_t one = 1;
+    [[maybe_unused]] auto written = write(notifierFd, &one, sizeof(one));
+}
+
+void ControlReactor::run()
+{
+    running = true;
+    epoll_event events[16];
+
+    while (running)
+    {
+        eraseRemovedSources();
+
+        int count = epoll_wait(epollFd, events, 16, -1);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            std::cerr << "epoll_wait failed: errno " << errno << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < count && running; ++i)
+        {
+            auto* source = static_cast<Source*>(events[i].data.ptr);
+            if (source->removed)
+                continue;
+
+            switch (source->kind)
+            {
+                case SourceKind::notifier:
+                case SourceKind::timer:
+                {
+                    // Coalesce: however many notifications/expirations piled up, handle them once
+                    uint64_t counter;
+                    if (read(source->fd, &counter, sizeof(counter)) != sizeof(counter))
+                        continue;
+                    if (source->handler)
+                        source->handler();
+                    break;
+                }
+
+                case SourceKind::signal:
+                {
+                    signalfd_siginfo info;
+                    while (read(source->fd, &info, sizeof(info)) == sizeof(info))
+                        if (source->signalHandler)
+                            source->signalHandler((int)info.ssi_signo);
+                    break;
+                }
+
+                case SourceKind::readable:
+                    // On a hangup the handler still reads what's left (and sees the EOF)
+                    if (source->handler)
+                        source->handler();
+
+                    // Level-triggered: a hung-up fd nobody removed would wake us forever
+                    if ((events[i].events & (EPOLLHUP | EPOLLERR)) && !source->removed)
+                        remove(source->fd);
+                    break;
+            }
+        }
+    }
+}
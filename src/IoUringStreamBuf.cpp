@@ -0,0 +1,525 @@
+#include "../include/IoUringStreamBuf.h"
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+    constexpr size_t ioAlignment = 4096;  // Covers the logical block size of anything O_DIRECT runs on
+
+    uint64_t readSysfsNumber(const std::string& path)
+    {
+        std::ifstream file(path);
+        uint64_t value = 0;
+        file >> value;
+        return file ? value : 0;
+    }
+
+    uint32_t loadAcquire(uint32_t* p) { return std::atomic_ref<uint32_t>(*p).load(std::memory_order_acquire); }
+    void storeRelease(uint32_t* p, uint32_t value) { std::atomic_ref<uint32_t>(*p).store(value, std::memory_order_release); }
+
+    int ioUringEnter(int fd, uint32_t toSubmit, uint32_t minComplete, uint32_t flags)
+    {
+        return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0);
+    }
+}
+
+IoUringStreamBuf::~IoUringStreamBuf()
+{
+    drainReads();
+    closeRing();
+
+    for (auto& slot : slots)
+        std::free(slot.data);
+
+    if (fileFd >= 0)
+        close(fileFd);
+}
+
+bool IoUringStreamBuf::open(const std::string& path, const Options& options)
+{
+    requestedDirectIO = options.directIO;
+    if (!openFile(path))
+        return false;
+
+    uint32_t requested = options.blockBytes != 0 ? options.blockBytes : getDeviceBlockBytes(fileFd);
+    blockBytes = (uint32_t)((std::max<uint32_t>(requested, ioAlignment) + ioAlignment - 1) / ioAlignment * ioAlignment);
+    slots.resize(std::max<uint32_t>(options.blocksInFlight, 2));
+    for (auto& slot : slots)
+    {
+        if (posix_memalign((void**)&slot.data, ioAlignment, blockBytes) != 0)
+        {
+            slot.data = nullptr;
+            errorMessage = "Out of memory for the read-ahead blocks";
+            return false;
+        }
+    }
+
+    // Not fatal - pread() reads the same blocks
+    if (options.ioUring)
+        setupRing((uint32_t)slots.size());
+
+    dropBehind = options.dropBehind;
+    setg(nullptr, nullptr, nullptr);
+    position = 0;
+    return true;
+}
+
+bool IoUringStreamBuf::reopen(const std::string& path)
+{
+    // Reads still in flight land in the blocks - and may only now report the old media's failure
+    drainReads();
+
+    if (fileFd >= 0)
+        close(fileFd);
+    fileFd = -1;
+
+    for (auto& slot : slots)
+    {
+        slot.block = -1;
+        slot.state = SlotState::empty;
+    }
+
+    lastBlock = -1;
+    setg(nullptr, nullptr, nullptr);
+    position = 0;
+    return openFile(path);
+}
+
+void IoUringStreamBuf::drainReads()
+{
+    // The kernel may still be writing into the blocks
+    while (ringFd >= 0 && std::any_of(slots.begin(), slots.end(), [] (const Slot& s) { return s.state == SlotState::inFlight; }))
+        reapCompletions(true);
+}
+
+bool IoUringStreamBuf::openFile(const std::string& path)
+{
+    directIO = requestedDirectIO;
+    fileFd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | (directIO ? O_DIRECT : 0));
+    if (fileFd < 0 && directIO && errno == EINVAL)
+    {
+        // tmpfs and friends refuse O_DIRECT - the page cache it is
+        directIO = false;
+        fileFd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+
+    if (fileFd < 0)
+    {
+        errorMessage = "Could not open file: " + path + " (" + strerror(errno) + ")";
+        return false;
+    }
+
+    struct stat info {};
+    if (fstat(fileFd, &info) != 0)
+    {
+        errorMessage = "Could not stat file: " + path + " (" + strerror(errno) + ")";
+        close(fileFd);
+        fileFd = -1;
+        return false;
+    }
+    fileSize = (uint64_t)info.st_size;
+
+    // A hint only - nothing to do if it's ignored
+    if (!directIO)
+        posix_fadvise(fileFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    return true;
+}
+
+// The device's preferred request size, from sysfs: the optimal I/O size if it
+// reports one, else the largest request it takes. Spinning disks get the top
+// of the range, seeks being what they are. Not a block device (tmpfs, NFS): 1 MiB.
+uint32_t IoUringStreamBuf::getDeviceBlockBytes(int fd)
+{
+    constexpr uint64_t minBytes = 256 * 1024, maxBytes = 4 * 1024 * 1024, unknownBytes = 1024 * 1024;
+
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || major(info.st_dev) == 0)
+        return (uint32_t)unknownBytes;
+
+    // A partition has no queue of its own - it's its parent's
+    std::string device = "/sys/dev/block/" + std::to_string(major(info.st_dev)) + ":" + std::to_string(minor(info.st_dev));
+    std::string queue = device + "/queue/";
+    if (readSysfsNumber(queue + "max_sectors_kb") == 0)
+        queue = device + "/../queue/";
+
+    uint64_t bytes = readSysfsNumber(queue + "optimal_io_size");
+    if (bytes == 0)
+        bytes = readSysfsNumber(queue + "max_sectors_kb") * 1024;
+    if (bytes == 0)
+        return (uint32_t)unknownBytes;
+
+    if (readSysfsNumber(queue + "rotational") != 0)
+        bytes = maxBytes;
+
+    return (uint32_t)std::clamp(bytes, minBytes, maxBytes);
+}
+
+// The decoder has moved on to 'block': the one after the in-flight window is
+// worth the kernel starting on, and (dropBehind) the one left behind isn't worth keeping
+void IoUringStreamBuf::adviseMovedTo(int64_t block)
+{
+    if (directIO || block == lastBlock)
+        return;
+
+    int64_t total = numBlocks();
+    if ((int64_t)slots.size() < total)
+    {
+        int64_t upcoming = (block + (int64_t)slots.size()) % total;
+        posix_fadvise(fileFd, (off_t)upcoming * blockBytes, blockBytes, POSIX_FADV_WILLNEED);
+    }
+
+    if (dropBehind && lastBlock >= 0)
+        posix_fadvise(fileFd, (off_t)lastBlock * blockBytes, blockBytes, POSIX_FADV_DONTNEED);
+
+    lastBlock = block;
+}
+
+bool IoUringStreamBuf::setupRing(uint32_t entries)
+{
+    io_uring_params params {};
+    ringFd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ringFd < 0)
+        return false;
+
+    sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMap)
+        sqRingBytes = cqRingBytes = std::max(sqRingBytes, cqRingBytes);
+
+    sqRing = mmap(nullptr, sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED)
+    {
+        sqRing = nullptr;
+        closeRing();
+        return false;
+    }
+
+    cqRing = singleMap ? sqRing
+                       : mmap(nullptr, cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+    sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqeMap = mmap(nullptr, sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (cqRing == MAP_FAILED || sqeMap == MAP_FAILED)
+    {
+        cqRing = cqRing == MAP_FAILED ? nullptr : cqRing;
+        sqes = sqeMap == MAP_FAILED ? nullptr : (io_uring_sqe*)sqeMap;
+        closeRing();
+        return false;
+    }
+    sqes = (io_uring_sqe*)sqeMap;
+
+    auto* sq = (char*)sqRing;
+    sqHead = (uint32_t*)(sq + params.sq_off.head);
+    sqTail = (uint32_t*)(sq + params.sq_off.tail);
+    sqMask = (uint32_t*)(sq + params.sq_off.ring_mask);
+    sqArray = (uint32_t*)(sq + params.sq_off.array);
+
+    auto* cq = (char*)cqRing;
+    cqHead = (uint32_t*)(cq + params.cq_off.head);
+    cqTail = (uint32_t*)(cq + params.cq_off.tail);
+    cqMask = (uint32_t*)(cq + params.cq_off.ring_mask);
+    cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+    return true;
+}
+
+void IoUringStreamBuf::closeRing()
+{
+    if (sqes) munmap(sqes, sqesBytes);
+    if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingBytes);
+    if (sqRing) munmap(sqRing, sqRingBytes);
+    sqes = nullptr;
+    cqRing = sqRing = nullptr;
+
+    if (ringFd >= 0)
+        close(ringFd);
+    ringFd = -1;
+}
+
+IoUringStreamBuf::Slot* IoUringStreamBuf::findSlot(int64_t block)
+{
+    for (auto& slot : slots)
+        if (slot.block == block && slot.state != SlotState::empty)
+            return &slot;
+
+    return nullptr;
+}
+
+bool IoUringStreamBuf::submit(Slot& slot, int64_t block)
+{
+    slot.block = block;
+    slot.bytes = 0;
+    uint64_t offset = (uint64_t)block * blockBytes;
+    blockReads.fetch_add(1, std::memory_order_relaxed);
+
+    if (ringFd < 0)
+    {
+        // Whole blocks, so O_DIRECT's alignment holds; short only at the end of the file
+        uint32_t done = 0;
+        while (done < blockBytes)
+        {
+            ssize_t n = pread(fileFd, slot.data + done, blockBytes - done, (off_t)(offset + done));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0)
+            {
+                slot.state = SlotState::failed;
+                return false;
+            }
+            if (n == 0)
+                break;
+            done += (uint32_t)n;
+        }
+
+        slot.bytes = done;
+        slot.state = SlotState::ready;
+        return true;
+    }
+
+    queueRead(slot);
+    return true;
+}
+
+// Reads the rest of the slot's block, from slot.bytes on
+void IoUringStreamBuf::queueRead(Slot& slot)
+{
+    // Never more in flight than there are slots, and the ring has at least that many entries
+    uint32_t tail = *sqTail;
+    uint32_t index = tail & *sqMask;
+    io_uring_sqe& sqe = sqes[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_READ;
+    sqe.fd = fileFd;
+    sqe.addr = (uint64_t)(uintptr_t)(slot.data + slot.bytes);
+    sqe.len = blockBytes - slot.bytes;
+    sqe.off = (uint64_t)slot.block * blockBytes + slot.bytes;
+    sqe.user_data = (uint64_t)(&slot - slots.data());
+
+    sqArray[index] = index;
+    storeRelease(sqTail, tail + 1);
+    slot.state = SlotState::inFlight;
+    ++pendingSubmissions;
+}
+
+void IoUringStreamBuf::flushSubmissions()
+{
+    while (pendingSubmissions > 0)
+    {
+        int submitted = ioUringEnter(ringFd, pendingSubmissions, 0, 0);
+        if (submitted < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                continue;
+
+            // The ring is unusable - fail what's queued and carry on with pread()
+            for (auto& slot : slots)
+                if (slot.state == SlotState::inFlight)
+                    slot.state = SlotState::failed;
+            pendingSubmissions = 0;
+            closeRing();
+            return;
+        }
+        pendingSubmissions -= std::min<uint32_t>((uint32_t)submitted, pendingSubmissions);
+    }
+}
+
+void IoUringStreamBuf::reapCompletions(bool wait)
+{
+    flushSubmissions();
+    if (ringFd < 0)
+        return;
+
+    if (wait && loadAcquire(cqTail) == *cqHead)
+        ioUringEnter(ringFd, 0, 1, IORING_ENTER_GETEVENTS);  // EINTR: the caller loops
+
+    uint32_t head = *cqHead;
+    while (head != loadAcquire(cqTail))
+    {
+        const io_uring_cqe& cqe = cqes[head & *cqMask];
+        if (cqe.user_data < slots.size())
+        {
+            Slot& slot = slots[cqe.user_data];
+            if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+            {
+                queueRead(slot);
+            }
+            else if (cqe.res < 0)
+            {
+                slot.state = SlotState::failed;
+            }
+            else
+            {
+                // Reads can come back short mid-file (partly cached pages, network
+                // filesystems) - only a zero-length read or the file's end finishes a block
+                slot.bytes += (uint32_t)cqe.res;
+                uint64_t end = (uint64_t)slot.block * blockBytes + slot.bytes;
+                if (cqe.res > 0 && slot.bytes < blockBytes && end < fileSize)
+                    queueRead(slot);
+                else
+                    slot.state = SlotState::ready;
+            }
+        }
+        ++head;
+    }
+    storeRelease(cqHead, head);
+
+    // The rest of any short reads
+    flushSubmissions();
+}
+
+IoUringStreamBuf::Slot* IoUringStreamBuf::loadBlock(int64_t block)
+{
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        Slot* slot = findSlot(block);
+        while (!slot)
+        {
+            // A random access (seek) - all blocks in flight means waiting for one
+            slot = findFreeSlot(block);
+            if (slot)
+                submit(*slot, block);
+            else
+                reapCompletions(true);
+        }
+
+        if (slot->state == SlotState::inFlight)
+        {
+            readWaits.fetch_add(1, std::memory_order_relaxed);
+            while (slot->state == SlotState::inFlight)
+                reapCompletions(true);
+        }
+
+        if (slot->state == SlotState::ready)
+            return slot;
+
+        // Some filesystems take O_DIRECT opens but not the reads - drop it and read again
+        slot->state = SlotState::empty;
+        if (!directIO)
+            break;
+
+        directIO = false;
+        fcntl(fileFd, F_SETFL, fcntl(fileFd, F_GETFL) & ~O_DIRECT);
+    }
+
+    readErrors.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+// A slot not on its way in, preferring ones outside the read-ahead window from 'fromBlock'
+IoUringStreamBuf::Slot* IoUringStreamBuf::findFreeSlot(int64_t fromBlock)
+{
+    Slot* fallback = nullptr;
+    for (auto& slot : slots)
+    {
+        if (slot.state == SlotState::inFlight)
+            continue;
+        if (slot.state != SlotState::ready || !isInWindow(slot.block, fromBlock))
+            return &slot;
+        fallback = &slot;
+    }
+
+    return fallback;
+}
+
+bool IoUringStreamBuf::isInWindow(int64_t block, int64_t fromBlock) const
+{
+    int64_t total = numBlocks();
+    return total > 0 && ((block - fromBlock) % total + total) % total < (int64_t)slots.size();
+}
+
+// Keeps the blocks after 'fromBlock' coming, wrapping to the start of the file.
+// Without the ring there's nothing to gain from reading ahead on this thread.
+void IoUringStreamBuf::readAhead(int64_t fromBlock)
+{
+    if (ringFd < 0)
+        return;
+
+    reapCompletions(false);
+
+    int64_t total = numBlocks();
+    int64_t window = std::min<int64_t>((int64_t)slots.size(), total);
+    for (int64_t ahead = 1; ahead < window && ringFd >= 0; ++ahead)
+    {
+        int64_t block = (fromBlock + ahead) % total;
+        if (findSlot(block))
+            continue;
+
+        Slot* victim = findFreeSlot(fromBlock);
+        if (!victim || (victim->state == SlotState::ready && isInWindow(victim->block, fromBlock)))
+            break;
+
+        submit(*victim, block);
+    }
+
+    if (ringFd >= 0)
+        flushSubmissions();
+}
+
+std::streambuf::int_type IoUringStreamBuf::underflow()
+{
+    if (gptr() && gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+
+    uint64_t next = eback() ? position + (uint64_t)(egptr() - eback()) : position;
+    if (next >= fileSize)
+        return traits_type::eof();
+
+    auto block = (int64_t)(next / blockBytes);
+    Slot* slot = loadBlock(block);
+    readAhead(block);
+    adviseMovedTo(block);
+
+    uint64_t blockStart = (uint64_t)block * blockBytes;
+    if (!slot || slot->bytes <= next - blockStart)
+    {
+        setg(nullptr, nullptr, nullptr);
+        position = next;
+        return traits_type::eof();
+    }
+
+    position = blockStart;
+    setg(slot->data, slot->data + (next - blockStart), slot->data + slot->bytes);
+    return traits_type::to_int_type(*gptr());
+}
+
+std::streambuf::pos_type IoUringStreamBuf::seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode mode)
+{
+    auto current = (off_type)(eback() ? position + (uint64_t)(gptr() - eback()) : position);
+
+    off_type target = offset;
+    if (direction == std::ios_base::cur) target += current;
+    else if (direction == std::ios_base::end) target += (off_type)fileSize;
+
+    return seekpos(pos_type(target), mode);
+}
+
+std::streambuf::pos_type IoUringStreamBuf::seekpos(pos_type target, std::ios_base::openmode)
+{
+    auto offset = (off_type)target;
+    if (offset < 0 || (uint64_t)offset > fileSize)
+        return pos_type(off_type(-1));
+
+    // Within what's already mapped in: just move the read pointer
+    auto wanted = (uint64_t)offset;
+    if (eback() && wanted >= position && wanted < position + (uint64_t)(egptr() - eback()))
+    {
+        setg(eback(), eback() + (wanted - position), egptr());
+    }
+    else
+    {
+        setg(nullptr, nullptr, nullptr);
+        position = wanted;
+    }
+
+    return target;
+}
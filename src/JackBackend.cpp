@@ -0,0 +1,209 @@
+#include "../include/JackBackend.h"
+#include <iostream>
+
+JackBackend::~JackBackend()
+{
+    stop();
+    if (client)
+        jack_client_close(client);
+}
+
+bool JackBackend::open(const Options& options)
+{
+    jack_status_t status;
+    client = jack_client_open(options.clientName.c_str(), JackNullOption, &status);
+    if (!client)
+    {
+        errorMessage = "Failed to open JACK client. Is JACK server running?\nTry: jackd -d alsa -r 48000 -p 256";
+        return false;
+    }
+
+    sampleRate = jack_get_sample_rate(client);
+    blockSize.store(jack_get_buffer_size(client), std::memory_order_relaxed);
+
+    // Create JACK output ports
+    for (uint32_t ch = 0; ch < options.numOutputChannels; ++ch)
+    {
+        std::string portName = "output_" + std::to_string(ch + 1);
+        auto* port = jack_port_register(client, portName.c_str(), JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+        if (!port)
+        {
+            errorMessage = "Failed to register JACK output port " + std::to_string(ch);
+            return false;
+        }
+        outputPorts.push_back(port);
+    }
+    outputBuffers.resize(outputPorts.size(), nullptr);
+
+    // MIDI input for control
+    if (options.midiInput)
+    {
+        midiInputPort = jack_port_register(client, "midi_in", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+        if (!midiInputPort)
+            std::cerr << "Warning: Failed to register JACK MIDI input port (MIDI control disabled)" << std::endl;
+    }
+
+    // MIDI output for MTC / MIDI clock (not auto-connected)
+    if (options.midiOutput)
+    {
+        midiOutputPort = jack_port_register(client, "midi_out", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+        if (!midiOutputPort)
+            std::cerr << "Warning: Failed to register JACK MIDI output port (MTC/clock disabled)" << std::endl;
+    }
+
+    // LTC output (not auto-connected - route it to the timecode input of your gear)
+    if (options.ltcOutput)
+    {
+        ltcOutputPort = jack_port_register(client, "ltc_out", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+        if (!ltcOutputPort)
+            std::cerr << "Warning: Failed to register JACK LTC output port (LTC disabled)" << std::endl;
+    }
+
+    if (jack_set_process_callback(client, process, this) != 0)
+    {
+        errorMessage = "Failed to set JACK process callback";
+        return false;
+    }
+
+    if (jack_set_xrun_callback(client, xrun, this) != 0)
+        std::cerr << "Warning: Failed to set JACK xrun callback (xruns won't be counted)" << std::endl;
+
+    if (jack_set_buffer_size_callback(client, bufferSizeChanged, this) != 0)
+        std::cerr << "Warning: Failed to set JACK buffer size callback (period changes won't be tracked)" << std::endl;
+
+    if (jack_set_latency_callback(client, latencyChanged, this) != 0)
+        std::cerr << "Warning: Failed to set JACK latency callback (seeks won't compensate for output latency)" << std::endl;
+
+    return true;
+}
+
+bool JackBackend::start(ProcessCallback callback)
+{
+    processCallback = std::move(callback);
+
+    // Register as JACK Transport timebase master
+    if (timebaseSource && jack_set_timebase_callback(client, 0, timebase, this) != 0)
+    {
+        errorMessage = "Failed to set JACK timebase callback";
+        return false;
+    }
+
+    if (jack_activate(client) != 0)
+    {
+        errorMessage = "Failed to activate JACK client";
+        return false;
+    }
+
+    active = true;
+    connectOutputs();
+    updateOutputLatency();
+    return true;
+}
+
+void JackBackend::stop()
+{
+    if (active)
+    {
+        jack_deactivate(client);
+        active = false;
+    }
+}
+
+void JackBackend::connectOutputs()
+{
+    // Auto-connect JACK ports to system playback
+    const char** systemPorts = jack_get_ports(client, "system:playback_", nullptr, JackPortIsInput);
+    if (!systemPorts)
+        return;
+
+    for (size_t ch = 0; ch < outputPorts.size() && systemPorts[ch]; ++ch)
+        jack_connect(client, jack_port_name(outputPorts[ch]), systemPorts[ch]);
+
+    jack_free(systemPorts);
+}
+
+int JackBackend::process(jack_nframes_t nframes, void* arg)
+{
+    auto* self = static_cast<JackBackend*>(arg);
+    if (!self->processCallback)
+        return 0;
+
+    // Get JACK output buffers (raw float* pointers)
+    for (size_t ch = 0; ch < self->outputPorts.size(); ++ch)
+        self->outputBuffers[ch] = static_cast<float*>(jack_port_get_buffer(self->outputPorts[ch], nframes));
+
+    AudioProcessBlock block;
+    block.numFrames = nframes;
+
+    // Wrap JACK buffers in CHOC's BufferView (zero-copy)
+    block.output = choc::buffer::createChannelArrayView(self->outputBuffers.data(),
+                                                        (choc::buffer::ChannelCount)self->outputBuffers.size(),
+                                                        (choc::buffer::FrameCount)nframes);
+
+    if (self->ltcOutputPort)
+        block.ltcOutput = static_cast<float*>(jack_port_get_buffer(self->ltcOutputPort, nframes));
+
+    if (self->midiInputPort)
+    {
+        void* midiBuffer = jack_port_get_buffer(self->midiInputPort, nframes);
+        jack_nframes_t eventCount = jack_midi_get_event_count(midiBuffer);
+
+        for (jack_nframes_t i = 0; i < eventCount && block.numMidiEvents < maxMidiEventsPerBlock; ++i)
+        {
+            jack_midi_event_t event;
+            if (jack_midi_event_get(&event, midiBuffer, i) != 0)
+                continue;
+
+            self->midiEvents[block.numMidiEvents++] = { event.time, event.buffer, event.size };
+        }
+        block.midiEvents = self->midiEvents;
+    }
+
+    if (self->midiOutputPort)
+        block.midiOutput = jack_port_get_buffer(self->midiOutputPort, nframes);
+
+    self->processCallback(block);
+    return 0;
+}
+
+// Just count, the metrics server reports it
+int JackBackend::xrun(void* arg)
+{
+    static_cast<JackBackend*>(arg)->xruns.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+}
+
+int JackBackend::bufferSizeChanged(jack_nframes_t nframes, void* arg)
+{
+    auto* self = static_cast<JackBackend*>(arg);
+    self->blockSize.store(nframes, std::memory_order_relaxed);
+    if (self->onBlockSizeChanged)
+        self->onBlockSizeChanged(nframes);
+    return 0;
+}
+
+// The graph (or a port connection) changed how long our output takes to reach the hardware
+void JackBackend::latencyChanged(jack_latency_callback_mode_t mode, void* arg)
+{
+    if (mode == JackPlaybackLatency)
+        static_cast<JackBackend*>(arg)->updateOutputLatency();
+}
+
+void JackBackend::updateOutputLatency()
+{
+    if (outputPorts.empty())
+        return;
+
+    jack_latency_range_t range {};
+    jack_port_get_latency_range(outputPorts[0], JackPlaybackLatency, &range);
+    outputLatency.store(range.max, std::memory_order_relaxed);
+}
+
+// Called after the process callback - as timebase master we write our
+// current audio position to JACK Transport
+void JackBackend::timebase(jack_transport_state_t, jack_nframes_t, jack_position_t* pos, int, void* arg)
+{
+    auto* self = static_cast<JackBackend*>(arg);
+    pos->frame = (jack_nframes_t)self->timebaseSource();  // Master controls the timeline
+    pos->valid = (jack_position_bits_t)0;                 // We only provide frame count, no BBT/timecode
+}
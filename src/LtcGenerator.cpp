@@ -0,0 +1,182 @@
+#include "../include/LtcGenerator.h"
+#include <algorithm>
+#include <cmath>
+
+LtcGenerator::LtcGenerator(double sr, TimecodeRate r, float levelDb)
+    : sampleRate(static_cast<uint64_t>(sr)), rate(r),
+      amplitude(std::pow(10.0f, levelDb / 20.0f))
+{
+    // Longest frame (29.97 alternates between two lengths), plus one for rounding
+    maxSamplesPerFrame = static_cast<uint32_t>((sampleRate * rate.denominator + rate.numerator - 1) / rate.numerator) + 1;
+
+    slots = std::make_unique<Slot[]>(numSlots);
+    for (uint32_t i = 0; i < numSlots; ++i)
+        slots[i].samples.resize(maxSamplesPerFrame, 0.0f);
+}
+
+LtcGenerator::~LtcGenerator()
+{
+    stop();
+}
+
+void LtcGenerator::setTimelineLength(uint64_t outputFrames)
+{
+    uint64_t length = std::max<uint64_t>(outputFrames, 1);
+    framesPerLoop.store(rate.frameIndexAt(length - 1, sampleRate) + 1, std::memory_order_relaxed);
+    timelineLength.store(length, std::memory_order_release);
+}
+
+void LtcGenerator::start(std::function<uint64_t()> source)
+{
+    playheadSource = std::move(source);
+    encoderTask(); // Have the first frames ready before the callback asks for them
+    encoderThread.start(5, [this] { encoderTask(); });
+}
+
+void LtcGenerator::stop()
+{
+    encoderThread.stop();
+}
+
+uint64_t LtcGenerator::sequenceAt(uint64_t position, uint64_t length, uint64_t loopFrames) const
+{
+    uint64_t loop = position / length;
+    return loop * loopFrames + rate.frameIndexAt(position % length, sampleRate);
+}
+
+void LtcGenerator::sequenceRange(uint64_t sequence, uint64_t length, uint64_t loopFrames,
+                                 uint64_t& start, uint64_t& end) const
+{
+    uint64_t loopStart = (sequence / loopFrames) * length;
+    uint64_t frameIndex = sequence % loopFrames;
+
+    // The last frame before the loop point is cut short by the wrap
+    start = loopStart + rate.frameStartSample(frameIndex, sampleRate);
+    end = loopStart + std::min(rate.frameStartSample(frameIndex + 1, sampleRate), length);
+}
+
+void LtcGenerator::encoderTask()
+{
+    uint64_t length = timelineLength.load(std::memory_order_acquire);
+    uint64_t loopFrames = framesPerLoop.load(std::memory_order_relaxed);
+    if (length == 0 || !playheadSource)
+        return;
+
+    uint64_t head = sequenceAt(playheadSource(), length, loopFrames);
+
+    // Stop one short of a full ring so the slot the callback may still be reading is never touched
+    for (uint64_t sequence = head; sequence < head + numSlots - 1; ++sequence)
+    {
+        auto& slot = slots[sequence % numSlots];
+        if (slot.sequence.load(std::memory_order_acquire) == sequence)
+            continue;
+
+        uint64_t frameIndex = sequence % loopFrames;
+        auto numSamples = static_cast<uint32_t>(rate.frameStartSample(frameIndex + 1, sampleRate)
+                                                - rate.frameStartSample(frameIndex, sampleRate));
+
+        // Seqlock-style publish: invalidate, write, then tag with the new sequence
+        slot.sequence.store(emptySlot, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        encodeFrame(frameIndex, slot.samples.data(), std::min(numSamples, maxSamplesPerFrame));
+        slot.sequence.store(sequence, std::memory_order_release);
+    }
+}
+
+void LtcGenerator::encodeFrame(uint64_t frameIndex, float* dest, uint32_t numSamples) const
+{
+    Timecode tc = frameIndexToTimecode(frameIndex, rate);
+
+    bool bits[80] = {};
+    auto setField = [&bits] (int firstBit, int numBits, uint32_t value)
+    {
+        for (int i = 0; i < numBits; ++i)
+            bits[firstBit + i] = ((value >> i) & 1) != 0;
+    };
+
+    // SMPTE 12M bit layout (BCD, LSB first); user bits left at zero
+    setField(0, 4, tc.frames % 10);
+    setField(8, 2, tc.frames / 10);
+    bits[10] = rate.dropFrame;
+    setField(16, 4, tc.seconds % 10);
+    setField(24, 3, tc.seconds / 10);
+    setField(32, 4, tc.minutes % 10);
+    setField(40, 3, tc.minutes / 10);
+    setField(48, 4, tc.hours % 10);
+    setField(56, 2, tc.hours / 10);
+
+    static constexpr bool syncWord[16] = { 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1 };
+    std::copy(std::begin(syncWord), std::end(syncWord), bits + 64);
+
+    // Polarity correction bit keeps the number of ones even, so every frame
+    // starts on the same level and slots can be encoded independently
+    int polarityBit = (rate.nominalFps == 25) ? 59 : 27;
+    if (std::count(std::begin(bits), std::end(bits), true) % 2 != 0)
+        bits[polarityBit] = true;
+
+    // Biphase mark: a transition at every bit boundary, plus one mid-cell for a 1
+    float level = amplitude;
+    for (uint64_t bit = 0; bit < 80; ++bit)
+    {
+        auto cellStart = static_cast<uint32_t>(bit * numSamples / 80);
+        auto cellMid   = static_cast<uint32_t>((2 * bit + 1) * numSamples / 160);
+        auto cellEnd   = static_cast<uint32_t>((bit + 1) * numSamples / 80);
+
+        level = -level;
+        if (bits[bit])
+        {
+            std::fill(dest + cellStart, dest + cellMid, level);
+            level = -level;
+            std::fill(dest + cellMid, dest + cellEnd, level);
+        }
+        else
+        {
+            std::fill(dest + cellStart, dest + cellEnd, level);
+        }
+    }
+}
+
+void LtcGenerator::renderBlock(float* output, uint32_t numFrames, uint64_t blockStartFrame, bool isRolling)
+{
+    uint64_t length = timelineLength.load(std::memory_order_acquire);
+    uint64_t loopFrames = framesPerLoop.load(std::memory_order_relaxed);
+
+    if (!isRolling || length == 0)
+    {
+        std::fill(output, output + numFrames, 0.0f);
+        return;
+    }
+
+    bool missed = false;
+    uint32_t done = 0;
+    while (done < numFrames)
+    {
+        uint64_t position = blockStartFrame + done;
+        uint64_t sequence = sequenceAt(position, length, loopFrames);
+
+        uint64_t frameStart, frameEnd;
+        sequenceRange(sequence, length, loopFrames, frameStart, frameEnd);
+        auto count = static_cast<uint32_t>(std::min<uint64_t>(numFrames - done, frameEnd - position));
+
+        auto& slot = slots[sequence % numSlots];
+        bool copied = false;
+        if (slot.sequence.load(std::memory_order_acquire) == sequence)
+        {
+            std::copy_n(slot.samples.data() + (position - frameStart), count, output + done);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            copied = slot.sequence.load(std::memory_order_relaxed) == sequence;
+        }
+
+        if (!copied)
+        {
+            // Not encoded yet (just jumped) - silence is better than wrong timecode
+            std::fill(output + done, output + done + count, 0.0f);
+            missed = true;
+        }
+
+        done += count;
+    }
+
+    if (missed)
+        missedFrames.fetch_add(1, std::memory_order_relaxed);
+}
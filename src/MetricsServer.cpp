@@ -0,0 +1,197 @@
+#include "../include/MetricsServer.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+MetricsServer::~MetricsServer()
+{
+    stop();
+}
+
+void MetricsServer::addCollector(Collector collector)
+{
+    collectors.push_back(std::move(collector));
+}
+
+void MetricsServer::writeCounter(std::string& out, const char* name, const char* help, double value)
+{
+    char text[256];
+    std::snprintf(text, sizeof(text), "# HELP %s %s\n# TYPE %s counter\n%s %.17g\n", name, help, name, name, value);
+    out += text;
+}
+
+void MetricsServer::writeGauge(std::string& out, const char* name, const char* help, double value)
+{
+    char text[256];
+    std::snprintf(text, sizeof(text), "# HELP %s %s\n# TYPE %s gauge\n%s %.17g\n", name, help, name, name, value);
+    out += text;
+}
+
+bool MetricsServer::openListener(const std::string& address)
+{
+    if (address.rfind("unix:", 0) == 0)
+    {
+        unixSocketPath = address.substr(5);
+
+        sockaddr_un addr {};
+        addr.sun_family = AF_UNIX;
+        if (unixSocketPath.empty() || unixSocketPath.size() >= sizeof(addr.sun_path))
+        {
+            errorMessage = "Invalid metrics socket path: " + unixSocketPath;
+            return false;
+        }
+        std::strncpy(addr.sun_path, unixSocketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        unlink(unixSocketPath.c_str());  // Left over from a previous run
+        if (listenFd < 0 || bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0)
+        {
+            errorMessage = "Cannot bind metrics socket " + unixSocketPath + ": " + std::strerror(errno);
+            return false;
+        }
+    }
+    else
+    {
+        auto colon = address.rfind(':');
+        std::string host = (colon == std::string::npos) ? "127.0.0.1" : address.substr(0, colon);
+        int port = std::atoi(address.c_str() + (colon == std::string::npos ? 0 : colon + 1));
+
+        sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)port);
+        if (port <= 0 || port > 65535 || inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1)
+        {
+            errorMessage = "Invalid metrics address: " + address;
+            return false;
+        }
+
+        listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int reuse = 1;
+        if (listenFd >= 0)
+            setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        if (listenFd < 0 || bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0)
+        {
+            errorMessage = "Cannot bind metrics address " + address + ": " + std::strerror(errno);
+            return false;
+        }
+    }
+
+    if (listen(listenFd, 4) != 0)
+    {
+        errorMessage = std::string("Cannot listen on metrics socket: ") + std::strerror(errno);
+        return false;
+    }
+
+    return true;
+}
+
+bool MetricsServer::start(const std::string& address)
+{
+    if (!openListener(address))
+    {
+        if (listenFd >= 0) close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    wakeFd = eventfd(0, EFD_CLOEXEC);
+    serverThread = std::thread([this] { serve(); });
+    return true;
+}
+
+void MetricsServer::stop()
+{
+    if (serverThread.joinable())
+    {
+        uint64_t one = 1;
+        [[maybe_unused]] auto written = write(wakeFd, &one, sizeof(one));
+        serverThread.join();
+    }
+
+    if (listenFd >= 0)
+    {
+        close(listenFd);
+        listenFd = -1;
+        if (!unixSocketPath.empty())
+            unlink(unixSocketPath.c_str());
+    }
+
+    if (wakeFd >= 0)
+    {
+        close(wakeFd);
+        wakeFd = -1;
+    }
+}
+
+void MetricsServer::serve()
+{
+    pollfd fds[2] = { { listenFd, POLLIN, 0 }, { wakeFd, POLLIN, 0 } };
+
+    for (;;)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR) continue;
+            return;
+        }
+
+        if (fds[1].revents)
+            return;
+
+        if (fds[0].revents & POLLIN)
+        {
+            int clientFd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (clientFd >= 0)
+            {
+                handleClient(clientFd);
+                close(clientFd);
+            }
+        }
+    }
+}
+
+void MetricsServer::handleClient(int clientFd)
+{
+    // Don't let a stuck client hold up the next scrape
+    timeval timeout { 1, 0 };
+    setsockopt(clientFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(clientFd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // Read the request headers; every path gets the metrics
+    char request[2048];
+    size_t received = 0;
+    while (received < sizeof(request) - 1)
+    {
+        ssize_t n = recv(clientFd, request + received, sizeof(request) - 1 - received, 0);
+        if (n <= 0) break;
+        received += (size_t)n;
+        request[received] = 0;
+        if (std::strstr(request, "\r\n\r\n") || std::strstr(request, "\n\n")) break;
+    }
+
+    std::string body;
+    body.reserve(8192);
+    for (auto& collector : collectors)
+        collector(body);
+
+    std::string response = "HTTP/1.0 200 OK\r\n"
+                           "Content-Type: text/plain; version=0.0.4\r\n"
+                           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                           "Connection: close\r\n\r\n" + body;
+
+    size_t sent = 0;
+    while (sent < response.size())
+    {
+        ssize_t n = send(clientFd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += (size_t)n;
+    }
+}
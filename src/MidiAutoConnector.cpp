@@ -0,0 +1,96 @@
+#include "../include/MidiAutoConnector.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+
+MidiAutoConnector::MidiAutoConnector(jack_client_t* c, jack_port_t* port, std::vector<std::string> devicePatterns)
+    : client(c), midiInputPort(port), patterns(std::move(devicePatterns))
+{
+    for (auto& pattern : patterns)
+        std::transform(pattern.begin(), pattern.end(), pattern.begin(), ::tolower);
+
+    std::erase_if(patterns, [] (const std::string& p) { return p.empty(); });
+}
+
+MidiAutoConnector::~MidiAutoConnector()
+{
+    stop();
+}
+
+bool MidiAutoConnector::registerCallbacks()
+{
+    if (!client || !midiInputPort)
+        return false;
+
+    return jack_set_port_registration_callback(client, portRegistrationCallback, this) == 0
+        && jack_set_port_connect_callback(client, portConnectCallback, this) == 0;
+}
+
+void MidiAutoConnector::start()
+{
+    if (!client || !midiInputPort || patterns.empty())
+        return;
+
+    // Interval 0: the worker only runs when a notification triggers it
+    worker.start(0, [this] { reconnectIfNeeded(); });
+    worker.trigger();
+}
+
+void MidiAutoConnector::stop()
+{
+    worker.stop();
+}
+
+void MidiAutoConnector::portRegistrationCallback(jack_port_id_t, int registered, void* arg)
+{
+    // A new port appeared - maybe the controller was plugged in
+    if (registered)
+        static_cast<MidiAutoConnector*>(arg)->worker.trigger();
+}
+
+void MidiAutoConnector::portConnectCallback(jack_port_id_t, jack_port_id_t, int connected, void* arg)
+{
+    // Something got disconnected - maybe our controller (the worker checks)
+    if (!connected)
+        static_cast<MidiAutoConnector*>(arg)->worker.trigger();
+}
+
+bool MidiAutoConnector::matchesPattern(const char* portName) const
+{
+    std::string lowerName = portName;
+    std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
+
+    return std::any_of(patterns.begin(), patterns.end(),
+                       [&] (const std::string& p) { return lowerName.find(p) != std::string::npos; });
+}
+
+void MidiAutoConnector::reconnectIfNeeded()
+{
+    if (jack_port_connected(midiInputPort) > 0)
+        return;
+
+    const char** midiPorts = jack_get_ports(client, nullptr, JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput);
+    if (!midiPorts)
+        return;
+
+    bool connected = false;
+    for (int i = 0; midiPorts[i] != nullptr; i++)
+    {
+        if (matchesPattern(midiPorts[i])
+             && jack_connect(client, midiPorts[i], jack_port_name(midiInputPort)) == 0)
+        {
+            std::cout << "✓ MIDI: " << midiPorts[i] << std::endl;
+            reconnectCount.fetch_add(1, std::memory_order_relaxed);
+            connected = true;
+            break; // Connect to first matching device
+        }
+    }
+    jack_free(midiPorts);
+
+    // Only report a missing device once until it shows up again
+    if (!connected && !reportedMissing)
+        std::cout << "⚠ No MIDI device found - waiting for one to be plugged in" << std::endl;
+
+    reportedMissing = !connected;
+}
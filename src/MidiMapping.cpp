@@ -0,0 +1,249 @@
+#include "../include/MidiMapping.h"
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    struct ActionName
+    {
+        MidiAction action;
+        const char* name;
+    };
+
+    constexpr ActionName actionNames[] =
+    {
+        { MidiAction::play,        "play" },
+        { MidiAction::pause,       "pause" },
+        { MidiAction::togglePause, "togglePause" },
+        { MidiAction::pauseOrStop, "pauseOrStop" },
+        { MidiAction::stop,        "stop" },
+        { MidiAction::gain,        "gain" },
+        { MidiAction::seek,        "seek" },
+        { MidiAction::cue,         "cue" },
+        { MidiAction::next,        "next" },
+        { MidiAction::previous,    "previous" },
+    };
+
+    const char* typeName(MidiMessageType type)
+    {
+        switch (type)
+        {
+            case MidiMessageType::note:          return "note";
+            case MidiMessageType::programChange: return "program";
+            default:                             return "cc";
+        }
+    }
+}
+
+const char* MidiMapping::actionName(MidiAction action)
+{
+    for (const auto& entry : actionNames)
+        if (entry.action == action)
+            return entry.name;
+
+    return "none";
+}
+
+MidiAction MidiMapping::actionFromName(std::string_view name)
+{
+    for (const auto& entry : actionNames)
+        if (name == entry.name)
+            return entry.action;
+
+    // "playlistNext" reads naturally in configs; the cue list is this player's playlist
+    if (name == "playlistNext")
+        return MidiAction::next;
+    if (name == "playlistPrevious")
+        return MidiAction::previous;
+
+    return MidiAction::none;
+}
+
+void MidiMapping::addBinding(std::vector<MidiBinding>& bindings, const MidiBinding& binding)
+{
+    std::erase_if(bindings, [&] (const MidiBinding& b)
+    {
+        return b.type == binding.type && b.number == binding.number && b.channel == binding.channel;
+    });
+
+    bindings.push_back(binding);
+}
+
+MidiTable::MidiTable(const std::vector<MidiBinding>& bindings)
+    : entries(tableSize)
+{
+    for (const auto& binding : bindings)
+    {
+        uint8_t firstChannel = binding.channel < 0 ? 0 : static_cast<uint8_t>(binding.channel);
+        uint8_t lastChannel = binding.channel < 0 ? 15 : static_cast<uint8_t>(binding.channel);
+
+        for (uint8_t channel = firstChannel; channel <= lastChannel; ++channel)
+            entries[tableIndex(binding.type, channel, binding.number)] = { binding.action, binding.parameter };
+    }
+}
+
+bool MidiTable::decode(const uint8_t* data, size_t size, MidiMessageType& type,
+                         uint8_t& channel, uint8_t& number, uint8_t& value)
+{
+    if (size < 2)
+        return false;
+
+    uint8_t status = data[0] & 0xF0;
+    channel = data[0] & 0x0F;
+    number = data[1] & 0x7F;
+
+    switch (status)
+    {
+        case 0xB0:
+            if (size < 3) return false;
+            type = MidiMessageType::controlChange;
+            value = data[2] & 0x7F;
+            return true;
+
+        case 0x90:
+            // Note-on with velocity 0 is a note-off - nothing is bound to releases
+            if (size < 3 || data[2] == 0) return false;
+            type = MidiMessageType::note;
+            value = data[2] & 0x7F;
+            return true;
+
+        case 0xC0:
+            type = MidiMessageType::programChange;
+            value = 127;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+MidiControl MidiTable::lookup(const uint8_t* data, size_t size) const
+{
+    MidiControl control;
+    MidiMessageType type;
+    uint8_t channel, number, value;
+
+    if (entries.empty() || !decode(data, size, type, channel, number, value))
+        return control;
+
+    const Entry& entry = entries[tableIndex(type, channel, number)];
+    control.action = entry.action;
+    control.parameter = entry.parameter;
+    control.value = value / 127.0f;
+    control.pressed = (type != MidiMessageType::controlChange) || value >= 64;
+    return control;
+}
+
+bool MidiMapping::captureIfLearning(const uint8_t* data, size_t size)
+{
+    if (!learnArmed.load(std::memory_order_acquire))
+        return false;
+
+    MidiMessageType type;
+    uint8_t channel, number, value;
+    if (!MidiTable::decode(data, size, type, channel, number, value))
+        return false;
+
+    uint32_t packed = ((static_cast<uint32_t>(type) << 4 | channel) << 8 | number) + 1;
+    learnedMessage.store(packed, std::memory_order_release);
+    learnArmed.store(false, std::memory_order_release);
+    return true;
+}
+
+bool MidiMapping::getLearnedMessage(MidiBinding& binding)
+{
+    uint32_t packed = learnedMessage.exchange(0, std::memory_order_acq_rel);
+    if (packed == 0)
+        return false;
+
+    packed -= 1;
+    binding = {};
+    binding.type = static_cast<MidiMessageType>(packed >> 12);
+    binding.channel = static_cast<int>((packed >> 8) & 0x0F);
+    binding.number = static_cast<uint8_t>(packed & 0x7F);
+    return true;
+}
+
+std::vector<MidiBinding> MidiMapping::defaultBindings(int numCuePoints, int cueBaseNote)
+{
+    // The original hard-wired controller layout, plus one note per cue point
+    std::vector<MidiBinding> defaults =
+    {
+        { MidiMessageType::controlChange, -1, 1, MidiAction::play,        0.0f },
+        { MidiMessageType::controlChange, -1, 2, MidiAction::pauseOrStop, 0.0f },
+        { MidiMessageType::controlChange, -1, 3, MidiAction::gain,        0.0f },
+    };
+
+    for (int i = 0; i < numCuePoints && cueBaseNote + i < 128; ++i)
+        defaults.push_back({ MidiMessageType::note, -1, static_cast<uint8_t>(cueBaseNote + i),
+                             MidiAction::cue, static_cast<float>(i) });
+
+    return defaults;
+}
+
+std::vector<MidiBinding> MidiMapping::parseBindings(const choc::value::ValueView& json)
+{
+    std::vector<MidiBinding> result;
+
+    for (uint32_t i = 0; i < json.size(); ++i)
+    {
+        auto entry = json[i];
+        MidiBinding binding;
+
+        auto type = entry["type"].getWithDefault<std::string>("cc");
+        if (type == "cc")           binding.type = MidiMessageType::controlChange;
+        else if (type == "note")    binding.type = MidiMessageType::note;
+        else if (type == "program") binding.type = MidiMessageType::programChange;
+        else
+        {
+            std::cout << "Warning: midiMapping[" << i << "]: unknown type '" << type << "', ignored" << std::endl;
+            continue;
+        }
+
+        int number = entry["number"].getWithDefault<int>(-1);
+        if (number < 0 || number > 127)
+        {
+            std::cout << "Warning: midiMapping[" << i << "]: number must be 0-127, ignored" << std::endl;
+            continue;
+        }
+        binding.number = static_cast<uint8_t>(number);
+
+        int channel = entry["channel"].getWithDefault<int>(0);  // 0 or absent = any channel
+        binding.channel = (channel >= 1 && channel <= 16) ? channel - 1 : -1;
+
+        auto action = entry["action"].getWithDefault<std::string>("");
+        binding.action = actionFromName(action);
+        if (binding.action == MidiAction::none)
+        {
+            std::cout << "Warning: midiMapping[" << i << "]: unknown action '" << action << "', ignored" << std::endl;
+            continue;
+        }
+
+        if (binding.action == MidiAction::seek)
+            binding.parameter = entry["seconds"].getWithDefault<float>(10.0f);
+        else if (binding.action == MidiAction::cue)
+            binding.parameter = static_cast<float>(entry["cue"].getWithDefault<int>(0));
+
+        result.push_back(binding);
+    }
+
+    return result;
+}
+
+std::string MidiMapping::toJson(const MidiBinding& binding)
+{
+    std::ostringstream json;
+    json << "{ \"type\": \"" << typeName(binding.type) << "\"";
+    if (binding.channel >= 0)
+        json << ", \"channel\": " << (binding.channel + 1);
+    json << ", \"number\": " << static_cast<int>(binding.number)
+         << ", \"action\": \"" << actionName(binding.action) << "\"";
+
+    if (binding.action == MidiAction::seek)
+        json << ", \"seconds\": " << binding.parameter;
+    else if (binding.action == MidiAction::cue)
+        json << ", \"cue\": " << static_cast<int>(binding.parameter);
+
+    json << " }";
+    return json.str();
+}
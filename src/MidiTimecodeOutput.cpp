@@ -0,0 +1,191 @@
+#include "../include/MidiTimecodeOutput.h"
+#include <jack/midiport.h>
+#include <algorithm>
+#include <cmath>
+
+MidiTimecodeOutput::MidiTimecodeOutput(double sr, TimecodeRate r, bool mtc, bool clock, double clockBpm)
+    : sampleRate(sr), rate(r), sendMtc(mtc), sendClock(clock)
+{
+    quarterFrameRate = rate;
+    quarterFrameRate.numerator *= 4;
+
+    // 24 clocks per quarter note
+    samplesPerClock = sampleRate * 60.0 / (std::max(clockBpm, 1.0) * 24.0);
+}
+
+uint8_t MidiTimecodeOutput::mtcRateCode() const
+{
+    if (rate.dropFrame) return 2;
+    switch (rate.nominalFps)
+    {
+        case 24: return 0;
+        case 25: return 1;
+        default: return 3;
+    }
+}
+
+void MidiTimecodeOutput::addEvent(uint32_t offset, const uint8_t* data, uint8_t size)
+{
+    if (numEvents >= maxEventsPerBlock)
+        return;
+
+    auto& event = events[numEvents++];
+    event.offset = offset;
+    event.size = size;
+    std::copy(data, data + size, event.data);
+}
+
+void MidiTimecodeOutput::addFullFrame(uint32_t offset, uint64_t timelineFrame)
+{
+    if (!sendMtc)
+        return;
+
+    auto sr = static_cast<uint64_t>(sampleRate);
+    Timecode tc = frameIndexToTimecode(rate.frameIndexAt(timelineFrame, sr), rate);
+
+    // Full Frame message - tells receivers to jump rather than wait for 8 quarter-frames
+    const uint8_t message[10] = { 0xF0, 0x7F, 0x7F, 0x01, 0x01,
+                                  static_cast<uint8_t>((mtcRateCode() << 5) | tc.hours),
+                                  static_cast<uint8_t>(tc.minutes),
+                                  static_cast<uint8_t>(tc.seconds),
+                                  static_cast<uint8_t>(tc.frames), 0xF7 };
+    addEvent(offset, message, sizeof(message));
+}
+
+void MidiTimecodeOutput::addClockLocate(uint32_t offset, uint64_t timelineFrame, bool wasRunning)
+{
+    if (!sendClock)
+        return;
+
+    if (wasRunning)
+    {
+        const uint8_t stop = 0xFC;
+        addEvent(offset, &stop, 1);
+    }
+
+    if (timelineFrame == 0)
+    {
+        const uint8_t start = 0xFA;
+        addEvent(offset, &start, 1);
+        return;
+    }
+
+    // Song Position Pointer counts 16th notes (6 clocks); receivers resume from the
+    // enclosing 16th, so seeks are accurate to 1/16 note on the receiving end
+    auto beats = static_cast<uint32_t>(std::min(timelineFrame / samplesPerClock / 6.0, 16383.0));
+    const uint8_t songPosition[3] = { 0xF2, static_cast<uint8_t>(beats & 0x7F),
+                                      static_cast<uint8_t>((beats >> 7) & 0x7F) };
+    const uint8_t resume = 0xFB;
+    addEvent(offset, songPosition, 3);
+    addEvent(offset, &resume, 1);
+}
+
+void MidiTimecodeOutput::renderSegment(uint32_t offset, uint32_t numFrames, uint64_t timelineFrame)
+{
+    auto sr = static_cast<uint64_t>(sampleRate);
+    uint64_t segmentEnd = timelineFrame + numFrames;
+
+    if (sendMtc)
+    {
+        uint64_t quarter = quarterFrameRate.frameIndexAt(timelineFrame, sr);
+        if (quarterFrameRate.frameStartSample(quarter, sr) < timelineFrame)
+            ++quarter;
+
+        for (uint64_t when; (when = quarterFrameRate.frameStartSample(quarter, sr)) < segmentEnd; ++quarter)
+        {
+            // Each 8-message cycle spans two frames and carries the time of its first frame
+            auto piece = static_cast<uint8_t>(quarter % 8);
+            Timecode tc = frameIndexToTimecode((quarter / 8) * 2, rate);
+
+            uint8_t nibble = 0;
+            switch (piece)
+            {
+                case 0: nibble = tc.frames & 0x0F; break;
+                case 1: nibble = (tc.frames >> 4) & 0x01; break;
+                case 2: nibble = tc.seconds & 0x0F; break;
+                case 3: nibble = (tc.seconds >> 4) & 0x03; break;
+                case 4: nibble = tc.minutes & 0x0F; break;
+                case 5: nibble = (tc.minutes >> 4) & 0x03; break;
+                case 6: nibble = tc.hours & 0x0F; break;
+                case 7: nibble = ((tc.hours >> 4) & 0x01) | (mtcRateCode() << 1); break;
+            }
+
+            const uint8_t message[2] = { 0xF1, static_cast<uint8_t>((piece << 4) | nibble) };
+            addEvent(offset + static_cast<uint32_t>(when - timelineFrame), message, 2);
+        }
+    }
+
+    if (sendClock)
+    {
+        auto clockTime = [this] (uint64_t tick) { return static_cast<uint64_t>(std::ceil(tick * samplesPerClock)); };
+
+        auto tick = static_cast<uint64_t>(timelineFrame / samplesPerClock);
+        while (clockTime(tick) < timelineFrame)
+            ++tick;
+
+        const uint8_t clock = 0xF8;
+        for (uint64_t when; (when = clockTime(tick)) < segmentEnd; ++tick)
+            addEvent(offset + static_cast<uint32_t>(when - timelineFrame), &clock, 1);
+    }
+}
+
+void MidiTimecodeOutput::renderBlock(void* midiBuffer, uint32_t numFrames, uint64_t blockStartFrame, bool isRolling)
+{
+    jack_midi_clear_buffer(midiBuffer);
+    numEvents = 0;
+
+    if (!isRolling)
+    {
+        if (wasRolling && sendClock)
+        {
+            const uint8_t stop = 0xFC;
+            addEvent(0, &stop, 1);
+        }
+
+        // Report where we're parked, so displays follow stops and seeks made while not rolling
+        if (blockStartFrame != lastIdleFrame)
+        {
+            addFullFrame(0, blockStartFrame % timelineLength);
+            lastIdleFrame = blockStartFrame;
+        }
+    }
+    else
+    {
+        bool located = !wasRolling || blockStartFrame != expectedNextFrame;
+        if (located)
+        {
+            addFullFrame(0, blockStartFrame % timelineLength);
+            addClockLocate(0, blockStartFrame % timelineLength, wasRolling);
+        }
+
+        // Split at the loop point: the timeline restarts mid-block
+        uint32_t done = 0;
+        while (done < numFrames)
+        {
+            uint64_t timelineFrame = (blockStartFrame + done) % timelineLength;
+            auto count = static_cast<uint32_t>(std::min<uint64_t>(numFrames - done, timelineLength - timelineFrame));
+
+            if (timelineFrame == 0 && !(done == 0 && located))
+            {
+                addFullFrame(done, 0);
+                addClockLocate(done, 0, true);
+            }
+
+            renderSegment(done, count, timelineFrame);
+            done += count;
+        }
+
+        lastIdleFrame = ~uint64_t(0);
+    }
+
+    wasRolling = isRolling;
+    expectedNextFrame = blockStartFrame + (isRolling ? numFrames : 0);
+
+    // JACK requires events in time order; the block holds only a handful, so insertion sort it
+    for (size_t i = 1; i < numEvents; ++i)
+        for (size_t j = i; j > 0 && events[j - 1].offset > events[j].offset; --j)
+            std::swap(events[j - 1], events[j]);
+
+    for (size_t i = 0; i < numEvents; ++i)
+        jack_midi_event_write(midiBuffer, std::min(events[i].offset, numFrames - 1), events[i].data, events[i].size);
+}
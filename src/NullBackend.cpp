@@ -0,0 +1,77 @@
+#include "../include/NullBackend.h"
+#include "../include/RealtimeSetup.h"
+#include <chrono>
+
+NullBackend::~NullBackend()
+{
+    stop();
+}
+
+bool NullBackend::open(const Options& options)
+{
+    if (options.sampleRate <= 0 || options.blockSize == 0)
+    {
+        errorMessage = "Null backend needs a positive sample rate and block size";
+        return false;
+    }
+
+    sampleRate = options.sampleRate;
+    blockSize = options.blockSize;
+
+    channelData.assign(options.numOutputChannels, std::vector<float>(blockSize, 0.0f));
+    channelPointers.clear();
+    for (auto& channel : channelData)
+        channelPointers.push_back(channel.data());
+
+    // Keep the LTC encoder in the loop too, so load tests see its cost
+    if (options.ltcOutput)
+        ltcBuffer.assign(blockSize, 0.0f);
+
+    return true;
+}
+
+bool NullBackend::start(ProcessCallback callback)
+{
+    processCallback = std::move(callback);
+    running = true;
+    processThread = std::thread([this] { run(); });
+    return true;
+}
+
+void NullBackend::stop()
+{
+    running = false;
+    if (processThread.joinable())
+        processThread.join();
+}
+
+void NullBackend::run()
+{
+    using Clock = std::chrono::steady_clock;
+    auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(blockSize / sampleRate));
+    RealtimeSetup::prefaultStack();
+    auto deadline = Clock::now();
+
+    AudioProcessBlock block;
+    block.numFrames = blockSize;
+    block.output = choc::buffer::createChannelArrayView(channelPointers.data(),
+                                                        (choc::buffer::ChannelCount)channelPointers.size(),
+                                                        (choc::buffer::FrameCount)blockSize);
+    block.ltcOutput = ltcBuffer.empty() ? nullptr : ltcBuffer.data();
+
+    while (running)
+    {
+        processCallback(block);
+
+        deadline += period;
+        auto now = Clock::now();
+        if (now > deadline + period)
+        {
+            // A real device would have run dry - count it and re-anchor instead of bursting to catch up
+            xruns.fetch_add(1, std::memory_order_relaxed);
+            deadline = now;
+        }
+
+        std::this_thread::sleep_until(deadline);
+    }
+}
@@ -0,0 +1,128 @@
+#include "../include/OfflineRenderer.h"
+#include "../include/BufferedAudioFilePlayer.h"
+#include "../include/CallbackProfiler.h"
+#include "choc/audio/choc_AudioFileFormat_WAV.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+OfflineRenderer::OfflineRenderer(Options o)
+    : options(std::move(o))
+{
+    std::sort(options.seeks.begin(), options.seeks.end(),
+              [] (const Seek& a, const Seek& b) { return a.atSeconds < b.atSeconds; });
+}
+
+int OfflineRenderer::run()
+{
+    if (options.blockSize == 0 || options.numChannels == 0 || options.sampleRate <= 0)
+    {
+        std::cerr << "Error: block size, channel count and sample rate must be positive" << std::endl;
+        return 1;
+    }
+
+    BufferedAudioFilePlayer player(options.inputPath, options.sampleRate);
+    if (!player.isLoaded())
+    {
+        std::cerr << "Error loading audio file: " << player.getErrorMessage() << std::endl;
+        return 1;
+    }
+
+    double fileSeconds = (double)player.getTotalFrames() / player.getFileSampleRate();
+    double seconds = options.durationSeconds > 0 ? options.durationSeconds : fileSeconds;
+    auto totalFrames = static_cast<uint64_t>(seconds * options.sampleRate);
+
+    auto outputStream = std::make_shared<std::ofstream>(options.outputPath, std::ios::binary | std::ios::trunc);
+    if (!outputStream->is_open())
+    {
+        std::cerr << "Error: cannot create " << options.outputPath << std::endl;
+        return 1;
+    }
+
+    choc::audio::AudioFileProperties properties;
+    properties.formatName = "WAV";
+    properties.sampleRate = options.sampleRate;
+    properties.numChannels = options.numChannels;
+    properties.bitDepth = choc::audio::BitDepth::float32;
+
+    choc::audio::WAVAudioFileFormat<true> wavFormat;
+    auto writer = wavFormat.createWriter(outputStream, properties);
+    if (!writer)
+    {
+        std::cerr << "Error: cannot write WAV to " << options.outputPath << std::endl;
+        return 1;
+    }
+
+    std::cout << "Rendering " << std::fixed << std::setprecision(2) << seconds << "s -> " << options.outputPath
+              << " (" << options.numChannels << "ch @ " << options.sampleRate << " Hz, "
+              << options.blockSize << "-frame blocks" << (options.realtime ? ", real time" : "") << ")" << std::endl;
+
+    player.startPlayback(options.realtime);
+
+    choc::buffer::ChannelArrayBuffer<float> block(choc::buffer::Size::create(options.numChannels, options.blockSize));
+    CallbackProfiler profiler;
+    profiler.setBudget(options.blockSize, options.sampleRate);
+
+    size_t nextSeek = 0;
+    uint64_t renderedFrames = 0;
+    auto started = std::chrono::steady_clock::now();
+    auto deadline = started;
+
+    while (renderedFrames < totalFrames)
+    {
+        auto numFrames = static_cast<uint32_t>(std::min<uint64_t>(options.blockSize, totalFrames - renderedFrames));
+
+        // Scripted seeks take effect at the first block boundary at or after their time
+        while (nextSeek < options.seeks.size()
+               && options.seeks[nextSeek].atSeconds * options.sampleRate <= (double)renderedFrames)
+        {
+            player.seekToFrame((uint64_t)(options.seeks[nextSeek].toSeconds * player.getFileSampleRate()));
+            ++nextSeek;
+        }
+
+        if (!options.realtime)
+            player.fillBuffer();
+
+        CallbackProfiler::Cycle cycle;
+        auto view = block.getView().getStart(numFrames);
+        player.processBlock(view);
+        cycle.lap(CallbackProfiler::renderStage);
+        profiler.record(cycle);
+
+        if (!writer->appendFrames(view))
+        {
+            std::cerr << "Error: write to " << options.outputPath << " failed" << std::endl;
+            return 1;
+        }
+
+        renderedFrames += numFrames;
+
+        if (options.realtime)
+        {
+            deadline += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(numFrames / options.sampleRate));
+            std::this_thread::sleep_until(deadline);
+        }
+    }
+
+    writer->flush();
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    const auto& stats = player.getStats();
+    std::cout << "Rendered " << std::setprecision(2) << renderedFrames / options.sampleRate << "s in "
+              << std::setprecision(3) << wallSeconds << "s - realtime factor "
+              << std::setprecision(1) << (wallSeconds > 0 ? renderedFrames / options.sampleRate / wallSeconds : 0.0)
+              << "x" << std::endl;
+    std::cout << "  Underruns: " << stats.underruns.load() << " (" << stats.underrunFrames.load() << " frames), loops: "
+              << stats.loops.load() << ", read errors: " << stats.readErrors.load() << std::endl;
+    std::cout << "  Refill p50/p99/max: " << std::setprecision(1)
+              << stats.refillLatency.getPercentile(0.5) / 1000.0 << " / "
+              << stats.refillLatency.getPercentile(0.99) / 1000.0 << " / "
+              << stats.refillLatency.getMax() / 1000.0 << " us per chunk" << std::endl;
+    std::cout << profiler.getReport();
+
+    return stats.readErrors.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,230 @@
+#include "../include/RealtimeLogger.h"
+#include <syslog.h>
+#include <algorithm>
+#include <cstdarg>
+#include <cstring>
+#include <ctime>
+
+namespace
+{
+    const char* levelName(RealtimeLogger::Level level)
+    {
+        switch (level)
+        {
+            case RealtimeLogger::Level::debug:   return "DEBUG";
+            case RealtimeLogger::Level::warning: return "WARNING";
+            case RealtimeLogger::Level::error:   return "ERROR";
+            default:                             return "INFO";
+        }
+    }
+
+    int syslogPriority(RealtimeLogger::Level level)
+    {
+        switch (level)
+        {
+            case RealtimeLogger::Level::debug:   return LOG_DEBUG;
+            case RealtimeLogger::Level::warning: return LOG_WARNING;
+            case RealtimeLogger::Level::error:   return LOG_ERR;
+            default:                             return LOG_INFO;
+        }
+    }
+
+    uint64_t wallClockNs()
+    {
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+    }
+}
+
+RealtimeLogger& RealtimeLogger::get()
+{
+    static RealtimeLogger instance;
+    return instance;
+}
+
+RealtimeLogger::RealtimeLogger()
+{
+    slots = std::make_unique<Slot[]>(numSlots);
+    for (uint32_t i = 0; i < numSlots; ++i)
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+RealtimeLogger::~RealtimeLogger()
+{
+    stop();
+}
+
+bool RealtimeLogger::parseLevel(const std::string& name, Level& level)
+{
+    if (name == "debug")        level = Level::debug;
+    else if (name == "info")    level = Level::info;
+    else if (name == "warning") level = Level::warning;
+    else if (name == "error")   level = Level::error;
+    else return false;
+
+    return true;
+}
+
+bool RealtimeLogger::start(const std::string& target)
+{
+    if (started)
+        return true;
+
+    if (target.rfind("file:", 0) == 0)
+    {
+        std::string path = target.substr(5);
+        logFile = std::fopen(path.c_str(), "a");
+        if (!logFile)
+        {
+            errorMessage = "Cannot open log file " + path + ": " + std::strerror(errno);
+            return false;
+        }
+        sink = Sink::file;
+    }
+    else if (target == "syslog")
+    {
+        openlog("consoleAudioPlayer", LOG_PID, LOG_USER);
+        sink = Sink::syslog;
+    }
+    else if (target != "stdout")
+    {
+        errorMessage = "Unknown log target '" + target + "' (use stdout, syslog or file:/path)";
+        return false;
+    }
+
+    started = true;
+    writerThread.start(20, [this] { drain(); });
+    return true;
+}
+
+void RealtimeLogger::stop()
+{
+    writerThread.stop();
+    drain();
+
+    if (logFile)
+    {
+        std::fclose(logFile);
+        logFile = nullptr;
+    }
+    else if (sink == Sink::syslog)
+    {
+        closelog();
+    }
+
+    sink = Sink::console;
+    started = false;
+}
+
+void RealtimeLogger::log(Level level, const char* format, ...)
+{
+    if (!isEnabled(level))
+        return;
+
+    // Claim a slot; if the writer hasn't freed the next one yet the ring is full
+    uint64_t position = writePosition.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;)
+    {
+        slot = &slots[position & (numSlots - 1)];
+        auto sequence = slot->sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<int64_t>(sequence - position);
+
+        if (difference == 0)
+        {
+            if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            position = writePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    Record& record = slot->record;
+    record.timestampNs = wallClockNs();
+    record.level = level;
+
+    va_list args;
+    va_start(args, format);
+    int length = std::vsnprintf(record.text, sizeof(record.text), format, args);
+    va_end(args);
+    record.length = static_cast<uint16_t>(std::clamp(length, 0, static_cast<int>(sizeof(record.text)) - 1));
+
+    slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+void RealtimeLogger::drain()
+{
+    bool wroteAny = false;
+
+    for (;;)
+    {
+        Slot& slot = slots[readPosition & (numSlots - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != readPosition + 1)
+            break;
+
+        write(slot.record);
+        slot.sequence.store(readPosition + numSlots, std::memory_order_release);
+        ++readPosition;
+        wroteAny = true;
+    }
+
+    uint64_t drops = dropped.load(std::memory_order_relaxed);
+    if (drops != reportedDrops)
+    {
+        Record note;
+        note.level = Level::warning;
+        note.timestampNs = wallClockNs();
+        note.length = static_cast<uint16_t>(std::snprintf(note.text, sizeof(note.text),
+                                                          "Log ring full: %llu records dropped",
+                                                          static_cast<unsigned long long>(drops - reportedDrops)));
+        write(note);
+        reportedDrops = drops;
+        wroteAny = true;
+    }
+
+    if (wroteAny)
+    {
+        if (sink == Sink::file)
+            std::fflush(logFile);
+        else if (sink == Sink::console)
+            std::fflush(stdout);
+    }
+}
+
+void RealtimeLogger::write(const Record& record)
+{
+    switch (sink)
+    {
+        case Sink::syslog:
+            syslog(syslogPriority(record.level), "%.*s", static_cast<int>(record.length), record.text);
+            break;
+
+        case Sink::file:
+        {
+            time_t seconds = static_cast<time_t>(record.timestampNs / 1000000000ull);
+            tm local;
+            localtime_r(&seconds, &local);
+
+            char stamp[32];
+            std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &local);
+            std::fprintf(logFile, "%s.%03u [%s] %.*s\n", stamp,
+                         static_cast<unsigned>(record.timestampNs / 1000000 % 1000),
+                         levelName(record.level), static_cast<int>(record.length), record.text);
+            break;
+        }
+
+        case Sink::console:
+            // Same split the std::cout / std::cerr calls it replaces had
+            std::fprintf(record.level >= Level::warning ? stderr : stdout, "%.*s\n",
+                         static_cast<int>(record.length), record.text);
+            break;
+    }
+}
@@ -0,0 +1,92 @@
+#include "../include/RealtimeSetup.h"
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace
+{
+    size_t pageSize()
+    {
+        static const size_t size = (size_t)sysconf(_SC_PAGESIZE);
+        return size;
+    }
+}
+
+bool RealtimeSetup::lockMemory(std::string& report)
+{
+    if (mlockall(MCL_CURRENT) != 0)
+    {
+        report = std::string("memory not locked (") + strerror(errno) + ") - raise RLIMIT_MEMLOCK or grant CAP_IPC_LOCK";
+        return false;
+    }
+
+    report = "memory locked";
+    return true;
+}
+
+void RealtimeSetup::prefault(void* data, size_t numBytes)
+{
+    // A read alone can map the shared zero page; the write forces a private page
+    auto* bytes = static_cast<volatile unsigned char*>(data);
+    for (size_t i = 0; i < numBytes; i += pageSize())
+        bytes[i] = bytes[i];
+
+    if (numBytes > 0)
+        bytes[numBytes - 1] = bytes[numBytes - 1];
+}
+
+__attribute__((noinline)) void RealtimeSetup::prefaultStack()
+{
+    volatile unsigned char stack[stackPrefaultBytes];
+    for (size_t i = 0; i < sizeof(stack); i += pageSize())
+        stack[i] = 0;
+}
+
+std::string RealtimeSetup::configureThread(pthread_t thread, int cpu, int priority)
+{
+    std::string report;
+
+    if (cpu >= 0)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        int err = pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+        report = err == 0 ? "pinned to CPU " + std::to_string(cpu)
+                          : "not pinned to CPU " + std::to_string(cpu) + " (" + strerror(err) + ")";
+    }
+    else
+    {
+        report = "any CPU";
+    }
+
+    sched_param param {};
+    param.sched_priority = priority;
+    int err = pthread_setschedparam(thread, priority > 0 ? SCHED_FIFO : SCHED_OTHER, &param);
+
+    if (priority <= 0)
+        report += ", SCHED_OTHER";
+    else if (err == 0)
+        report += ", SCHED_FIFO " + std::to_string(priority);
+    else
+        report += ", SCHED_OTHER (SCHED_FIFO " + std::to_string(priority) + " refused: " + strerror(err) + ")";
+
+    return report;
+}
+
+int RealtimeSetup::loaderPriorityBelow(int audioPriority, int requested)
+{
+    // A realtime loader above a non-realtime audio thread would starve it
+    if (audioPriority <= 1 || requested == 0)
+        return 0;
+
+    // Far enough below to leave room for JACK's own helper threads
+    if (requested < 0)
+        return std::max(1, audioPriority - 10);
+
+    return std::min(requested, audioPriority - 1);
+}
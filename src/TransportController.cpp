@@ -0,0 +1,182 @@
+#include "../include/TransportController.h"
+#include <iostream>
+
+TransportController::TransportController(ControlReactor& reactor, BufferedAudioFilePlayer& player, AudioBackend& backend,
+                                         LtcGenerator* ltcGenerator, double readySeconds)
+    : reactor(reactor), player(player), backend(backend), ltcGenerator(ltcGenerator), readySeconds(readySeconds)
+{
+    setState(player.isStillPlaying() ? TransportState::playing : TransportState::paused);
+
+    // Safety net for a loader that can't get there (read errors, file shorter than readySeconds)
+    readyTimeout = reactor.createTimer();
+    reactor.onReadable(readyTimeout, [this]
+    {
+        if (!isWaiting())
+            return;
+
+        std::cout << "⚠ Buffer not ready after " << readyTimeoutMs << " ms - carrying on" << std::endl;
+        bufferReady();
+    });
+}
+
+const char* TransportController::stateName(TransportState state)
+{
+    switch (state)
+    {
+        case TransportState::stopped:    return "stopped";
+        case TransportState::prerolling: return "prerolling";
+        case TransportState::playing:    return "playing";
+        case TransportState::paused:     return "paused";
+        case TransportState::seeking:    return "seeking";
+    }
+    return "unknown";
+}
+
+void TransportController::play()
+{
+    switch (state)
+    {
+        case TransportState::stopped:
+            std::cout << "▶  Playing from start" << std::endl;
+            startPlaying();
+            break;
+        case TransportState::paused:
+            startPlaying();
+            break;
+        case TransportState::prerolling:
+        case TransportState::seeking:
+            playWhenReady = true;
+            break;
+        case TransportState::playing:
+            break;
+    }
+}
+
+void TransportController::pause()
+{
+    if (state == TransportState::playing)
+    {
+        player.pause();
+        backend.transportStop();
+        setState(TransportState::paused);
+    }
+    else if (isWaiting())
+    {
+        player.pause();  // Already silent - this drops the seek's latency measurement
+        playWhenReady = false;
+    }
+}
+
+void TransportController::togglePause()
+{
+    bool playingOrAboutTo = state == TransportState::playing || (isWaiting() && playWhenReady);
+    if (playingOrAboutTo)
+        pause();
+    else
+        play();
+}
+
+void TransportController::stop()
+{
+    // Already stopped (or on the way there): nothing to redo, nothing to re-read
+    if (state == TransportState::stopped || (state == TransportState::prerolling && !playWhenReady))
+        return;
+
+    canPlayFromCallback.store(false, std::memory_order_release);  // Before the FIFO is emptied
+    holdingAtZero.store(true, std::memory_order_release);
+    player.stop();  // Rewinds and empties the FIFO - the one preroll from 0 starts here
+    backend.transportLocate(0);
+    backend.transportStop();
+    if (ltcGenerator) ltcGenerator->resync();
+
+    waitForBuffer(TransportState::prerolling, false);
+}
+
+void TransportController::pauseOrStop()
+{
+    if (state == TransportState::playing)
+        pause();
+    else
+        stop();
+}
+
+void TransportController::seek(uint64_t fileFrame, bool thenPlay)
+{
+    bool resume = thenPlay || state == TransportState::playing || (isWaiting() && playWhenReady);
+
+    // Hold output while the FIFO refills, rather than counting underruns. Returns at
+    // once - the loader does the refill, and update() hears when it's far enough.
+    canPlayFromCallback.store(false, std::memory_order_release);
+    player.pause();
+    player.seekToFrame(fileFrame, resume);
+    holdingAtZero.store(false, std::memory_order_release);
+    if (ltcGenerator) ltcGenerator->resync();
+
+    waitForBuffer(TransportState::seeking, resume);
+}
+
+void TransportController::update()
+{
+    if (isWaiting() && player.isBuffered(readySeconds))
+        bufferReady();
+}
+
+void TransportController::waitForBuffer(TransportState waitingState, bool thenPlay)
+{
+    setState(waitingState);
+    playWhenReady = thenPlay;
+    player.armBufferedNotification(readySeconds);
+    reactor.armTimer(readyTimeout, readyTimeoutMs);
+
+    update();  // Already there (e.g. a seek into what was just buffered)
+}
+
+void TransportController::bufferReady()
+{
+    reactor.disarmTimer(readyTimeout);
+    bool fromStart = state == TransportState::prerolling;
+
+    if (playWhenReady)
+    {
+        if (fromStart)
+            std::cout << "▶  Playing from start" << std::endl;
+        startPlaying();
+    }
+    else if (fromStart)
+    {
+        // Pin JACK at 0 now the refill is done, once
+        backend.transportLocate(0);
+        setState(TransportState::stopped);
+    }
+    else
+    {
+        setState(TransportState::paused);
+    }
+}
+
+void TransportController::setState(TransportState newState)
+{
+    state = newState;
+    canPlayFromCallback.store(newState == TransportState::paused || newState == TransportState::stopped,
+                              std::memory_order_release);
+}
+
+bool TransportController::playFromCallback()
+{
+    // Paused, or stopped with the preroll done: the FIFO is ready, so play can start on
+    // the event's sample. play() still runs on the control thread for the rest.
+    if (!canPlayFromCallback.exchange(false, std::memory_order_acq_rel))
+        return false;
+
+    holdingAtZero.store(false, std::memory_order_release);
+    player.play();
+    return true;
+}
+
+void TransportController::startPlaying()
+{
+    holdingAtZero.store(false, std::memory_order_release);
+    player.play();
+    backend.transportStart();
+    setState(TransportState::playing);
+}
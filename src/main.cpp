@@ -4,13 +4,19 @@
 #include <filesystem>
 #include <iomanip>
 #include <algorithm>
+#include <optional>
+#include <future>
+#include <cmath>
+#include <cctype>
 #include <signal.h>
 #include <execinfo.h>
 #include <cstdlib>
+#include <cerrno>
 #include <unistd.h>
 #include <termios.h>
 #include <fcntl.h>
 #include <sys/select.h>
+#include <sstream>
 
 #ifdef __linux__
     #include <unistd.h>
@@ -23,9 +29,22 @@
 #include "choc/audio/choc_AudioFileFormat_WAV.h"
 #include "choc/audio/choc_AudioSampleData.h"
 #include "BufferedAudioFilePlayer.h"
-#include <jack/jack.h>
-#include <jack/transport.h>
-#include <jack/midiport.h>
+#include "LtcGenerator.h"
+#include "MidiTimecodeOutput.h"
+#include "MidiMapping.h"
+#include "MidiAutoConnector.h"
+#include "ControlReactor.h"
+#include "MetricsServer.h"
+#include "CallbackProfiler.h"
+#include "RealtimeLogger.h"
+#include "OfflineRenderer.h"
+#include "RealtimeSetup.h"
+#include "RcuPointer.h"
+#include "ConfigWatcher.h"
+#include "StartupTimer.h"
+#include "TransportController.h"
+#include "AudioBackend.h"
+#include "JackBackend.h"
 
 // Signal handler for debugging segfaults
 void signal_handler(int sig) {
@@ -73,15 +92,14 @@ void restoreTerminal(const TerminalState& state) {
     }
 }
 
-char getKeyPress() {
-    char c = 0;
-    read(STDIN_FILENO, &c, 1);
-    return c;
-}
-
+// Goes through the realtime logger (debug level), so it no longer flushes stdout
+// synchronously. Stream formatting allocates - not for the process callback.
 #define DEBUG_PRINT(msg) do { \
-    std::cout << "[DEBUG " << __FILE__ << ":" << __LINE__ << "] " << msg << std::endl; \
-    std::cout.flush(); \
+    if (RealtimeLogger::get().isEnabled(RealtimeLogger::Level::debug)) { \
+        std::ostringstream debugText; \
+        debugText << msg; \
+        RT_LOG_DEBUG("[DEBUG %s:%d] %s", __FILE__, __LINE__, debugText.str().c_str()); \
+    } \
 } while(0)
 
 struct Settings {
@@ -90,12 +108,53 @@ struct Settings {
     int outputChannels = 6;
     int inputChannels = 0;
     std::string audioFilePath = "../test_6ch.wav";
-    std::string preferredAudioInterface = "";
+    std::vector<std::string> replicaPaths;          // Copies on other media, read from if audioFilePath fails
+    std::string preferredAudioInterface = "";       // ALSA device for the alsa backend, e.g. "hw:0"
+    std::string audioBackend = "jack";             // "jack", "alsa" or "null"
 
     bool udpEnabled = true;
     std::string udpAddress = "255.255.255.255";
     int udpPort = 8080;
     std::string udpMessage = "LOOP";
+
+    bool ltcEnabled = false;
+    int ltcFrameRate = 25;        // 24, 25 or 30
+    bool ltcDropFrame = false;    // With 30: 29.97 drop-frame
+    float ltcLevelDb = -18.0f;
+
+    bool mtcEnabled = true;       // MTC quarter-frames on midi_out
+    int mtcFrameRate = 25;
+    bool mtcDropFrame = false;
+    bool midiClockEnabled = false; // MIDI beat clock on midi_out
+    double midiClockBpm = 120.0;
+
+    std::vector<double> cuePoints;  // Seconds into the file, for "cue" / "next" / "previous" MIDI actions
+    int midiCueBaseNote = 60;       // Unless midiMapping binds notes: this note jumps to cuePoints[0], +1 to [1], ...
+    std::vector<MidiBinding> midiMapping;  // Empty = CC1 play, CC2 pause/stop, CC3 gain; cue notes added if it has no notes
+    std::vector<std::string> midiDevicePatterns = { "pico", "circuitpython" };  // Auto-connect matches
+    float gainLimit = 1.0f;         // Ceiling for MIDI gain changes (0-1)
+
+    bool configReload = true;       // Watch the config file and apply live settings without a restart
+
+    double startupPrefillSeconds = 0.2;  // Buffered before audio starts, and after a stop or seek (negative = 90%)
+    double bufferMinSeconds = 2.0;       // The read-ahead depth adapts to the storage's read stalls within these -
+    double bufferMaxSeconds = 10.0;      // SD cards want the top end; the maximum is what gets allocated
+    bool ioUring = true;                 // Read-ahead on io_uring (false = pread), several blocks in flight
+    bool directIO = false;               // O_DIRECT reads, bypassing the page cache
+    int readAheadKiB = 0;                // Size of each read-ahead block (0 = tuned to the device, 256-4096)
+    int readsInFlight = 8;
+    bool dropPlayedCache = true;         // Evict played audio from the page cache (ignored with directIO)
+    int loaderChunkFrames = 0;           // Frames decoded per loader read (0 = one read-ahead block's worth)
+
+    bool metricsEnabled = false;
+    std::string metricsAddress = "127.0.0.1:9099";  // Or "unix:/run/consoleAudioPlayer.sock"
+
+    std::string logTarget = "stdout";  // Or "syslog", "file:/var/log/consoleAudioPlayer.log"
+    std::string logLevel = "info";     // debug, info, warning, error
+
+    bool lockMemory = true;   // mlockall + prefault the FIFO, so nothing pages in mid-show
+    int loaderCpu = -1;       // Pin the file loader to this core (-1 = let the scheduler pick)
+    int loaderPriority = -1;  // SCHED_FIFO priority, kept below the audio thread (-1 = auto, 0 = SCHED_OTHER)
 };
 
 std::string getConfigFilePath() {
@@ -120,153 +179,463 @@ std::string getConfigFilePath() {
     return searchPaths[0];
 }
 
+// Reads 'settingsFile' over the values already in 'settings'. False, with the
+// reason, if it can't be read or isn't valid JSON.
+bool parseSettings(const std::string& settingsFile, Settings& settings, std::string& error) {
+    try {
+        auto content = choc::file::loadFileAsString(settingsFile);
+        auto json = choc::json::parse(content);
+
+        settings.sampleRate     = json["sampleRate"]    .getWithDefault<int>(settings.sampleRate);
+        settings.blockSize      = json["blockSize"]     .getWithDefault<int>(settings.blockSize);
+        settings.outputChannels = json["outputChannels"].getWithDefault<int>(settings.outputChannels);
+        settings.inputChannels  = json["inputChannels"] .getWithDefault<int>(settings.inputChannels);
+        settings.audioFilePath  = json["audioFilePath"] .getWithDefault<std::string>(settings.audioFilePath);
+        settings.preferredAudioInterface = json["preferredAudioInterface"].getWithDefault<std::string>(settings.preferredAudioInterface);
+        settings.audioBackend   = json["audioBackend"]  .getWithDefault<std::string>(settings.audioBackend);
+
+        settings.udpEnabled     = json["udpEnabled"]    .getWithDefault<bool>(settings.udpEnabled);
+        settings.udpAddress     = json["udpAddress"]    .getWithDefault<std::string>(settings.udpAddress);
+        settings.udpPort        = json["udpPort"]       .getWithDefault<int>(settings.udpPort);
+        settings.udpMessage     = json["udpMessage"]    .getWithDefault<std::string>(settings.udpMessage);
+
+        settings.ltcEnabled     = json["ltcEnabled"]    .getWithDefault<bool>(settings.ltcEnabled);
+        settings.ltcFrameRate   = json["ltcFrameRate"]  .getWithDefault<int>(settings.ltcFrameRate);
+        settings.ltcDropFrame   = json["ltcDropFrame"]  .getWithDefault<bool>(settings.ltcDropFrame);
+        settings.ltcLevelDb     = json["ltcLevelDb"]    .getWithDefault<float>(settings.ltcLevelDb);
+
+        settings.mtcEnabled       = json["mtcEnabled"]      .getWithDefault<bool>(settings.mtcEnabled);
+        settings.mtcFrameRate     = json["mtcFrameRate"]    .getWithDefault<int>(settings.mtcFrameRate);
+        settings.mtcDropFrame     = json["mtcDropFrame"]    .getWithDefault<bool>(settings.mtcDropFrame);
+        settings.midiClockEnabled = json["midiClockEnabled"].getWithDefault<bool>(settings.midiClockEnabled);
+        settings.midiClockBpm     = json["midiClockBpm"]    .getWithDefault<double>(settings.midiClockBpm);
+
+        auto cuePoints = json["cuePoints"];
+        if (cuePoints.isArray()) {
+            for (uint32_t i = 0; i < cuePoints.size(); i++) {
+                settings.cuePoints.push_back(cuePoints[i].getWithDefault<double>(0.0));
+            }
+        }
+        settings.midiCueBaseNote  = json["midiCueBaseNote"] .getWithDefault<int>(settings.midiCueBaseNote);
+        settings.gainLimit        = json["gainLimit"]       .getWithDefault<float>(settings.gainLimit);
+        settings.configReload     = json["configReload"]    .getWithDefault<bool>(settings.configReload);
+        settings.startupPrefillSeconds = json["startupPrefillSeconds"].getWithDefault<double>(settings.startupPrefillSeconds);
+        settings.bufferMinSeconds = json["bufferMinSeconds"].getWithDefault<double>(settings.bufferMinSeconds);
+        settings.bufferMaxSeconds = json["bufferMaxSeconds"].getWithDefault<double>(settings.bufferMaxSeconds);
+        settings.ioUring       = json["ioUring"]      .getWithDefault<bool>(settings.ioUring);
+        settings.directIO      = json["directIO"]     .getWithDefault<bool>(settings.directIO);
+        settings.readAheadKiB  = json["readAheadKiB"] .getWithDefault<int>(settings.readAheadKiB);
+        settings.readsInFlight = json["readsInFlight"].getWithDefault<int>(settings.readsInFlight);
+        settings.dropPlayedCache   = json["dropPlayedCache"]  .getWithDefault<bool>(settings.dropPlayedCache);
+        settings.loaderChunkFrames = json["loaderChunkFrames"].getWithDefault<int>(settings.loaderChunkFrames);
+
+        settings.metricsEnabled = json["metricsEnabled"].getWithDefault<bool>(settings.metricsEnabled);
+        settings.metricsAddress = json["metricsAddress"].getWithDefault<std::string>(settings.metricsAddress);
+
+        settings.logTarget = json["logTarget"].getWithDefault<std::string>(settings.logTarget);
+        settings.logLevel  = json["logLevel"] .getWithDefault<std::string>(settings.logLevel);
+
+        settings.lockMemory     = json["lockMemory"]    .getWithDefault<bool>(settings.lockMemory);
+        settings.loaderCpu      = json["loaderCpu"]     .getWithDefault<int>(settings.loaderCpu);
+        settings.loaderPriority = json["loaderPriority"].getWithDefault<int>(settings.loaderPriority);
+
+        auto replicaPaths = json["replicaPaths"];
+        if (replicaPaths.isArray()) {
+            for (uint32_t i = 0; i < replicaPaths.size(); i++) {
+                settings.replicaPaths.push_back(replicaPaths[i].getWithDefault<std::string>(""));
+            }
+        }
+
+        auto devicePatterns = json["midiDevicePatterns"];
+        if (devicePatterns.isArray()) {
+            settings.midiDevicePatterns.clear();
+            for (uint32_t i = 0; i < devicePatterns.size(); i++) {
+                settings.midiDevicePatterns.push_back(devicePatterns[i].getWithDefault<std::string>(""));
+            }
+        }
+
+        auto midiMapping = json["midiMapping"];
+        if (midiMapping.isArray()) {
+            settings.midiMapping = MidiMapping::parseBindings(midiMapping);
+        }
+    } catch (const std::exception& e) {
+        error = e.what();
+        return false;
+    }
+    return true;
+}
+
 Settings loadSettings() {
     Settings settings;
     const std::string settingsFile = getConfigFilePath();
+    std::string error;
 
-    try {
-        if (std::filesystem::exists(settingsFile)) {
-            auto content = choc::file::loadFileAsString(settingsFile);
-            auto json = choc::json::parse(content);
+    if (std::filesystem::exists(settingsFile) && !parseSettings(settingsFile, settings, error)) {
+        std::cout << "Warning: Could not load settings, using defaults: " << error << std::endl;
+    }
+    return settings;
+}
+
+// The settings that can change while playing. Published to the process callback
+// as an immutable snapshot and replaced whole on every reload, so a cycle never
+// sees half of an old config and half of a new one.
+struct LiveConfig {
+    float gainLimit = 1.0f;
+    std::vector<double> cuePoints;
+    std::vector<MidiBinding> midiBindings;  // Resolved - the defaults when the config has none
+    MidiTable midiTable;                    // midiBindings compiled for the callback
+    std::string logLevel;
+};
 
-            settings.sampleRate     = json["sampleRate"]    .getWithDefault<int>(settings.sampleRate);
-            settings.blockSize      = json["blockSize"]     .getWithDefault<int>(settings.blockSize);
-            settings.outputChannels = json["outputChannels"].getWithDefault<int>(settings.outputChannels);
-            settings.inputChannels  = json["inputChannels"] .getWithDefault<int>(settings.inputChannels);
-            settings.audioFilePath  = json["audioFilePath"] .getWithDefault<std::string>(settings.audioFilePath);
-            settings.preferredAudioInterface = json["preferredAudioInterface"].getWithDefault<std::string>(settings.preferredAudioInterface);
+LiveConfig makeLiveConfig(const Settings& settings) {
+    LiveConfig config;
+    config.gainLimit = settings.gainLimit;
+    config.cuePoints = settings.cuePoints;
+    config.midiBindings = settings.midiMapping.empty()
+                              ? MidiMapping::defaultBindings((int)settings.cuePoints.size(), settings.midiCueBaseNote)
+                              : settings.midiMapping;
+
+    // A mapping of controls alone still gets the default cue notes
+    bool bindsNotes = std::any_of(config.midiBindings.begin(), config.midiBindings.end(),
+                                  [] (const MidiBinding& b) { return b.type == MidiMessageType::note; });
+    if (!bindsNotes) {
+        for (const auto& binding : MidiMapping::defaultBindings((int)settings.cuePoints.size(), settings.midiCueBaseNote))
+            if (binding.type == MidiMessageType::note)
+                config.midiBindings.push_back(binding);
+    }
+    config.midiTable = MidiTable(config.midiBindings);
+    config.logLevel = settings.logLevel;
+    return config;
+}
 
-            settings.udpEnabled     = json["udpEnabled"]    .getWithDefault<bool>(settings.udpEnabled);
-            settings.udpAddress     = json["udpAddress"]    .getWithDefault<std::string>(settings.udpAddress);
-            settings.udpPort        = json["udpPort"]       .getWithDefault<int>(settings.udpPort);
-            settings.udpMessage     = json["udpMessage"]    .getWithDefault<std::string>(settings.udpMessage);
+// A reload that fails any of these is rejected as a whole and the running config stays
+bool validateLiveConfig(const LiveConfig& config, double fileDuration, std::string& error) {
+    if (!(config.gainLimit >= 0.0f && config.gainLimit <= 1.0f)) {
+        error = "gainLimit must be between 0 and 1";
+        return false;
+    }
 
+    for (size_t i = 0; i < config.cuePoints.size(); i++) {
+        if (config.cuePoints[i] < 0.0 || config.cuePoints[i] >= fileDuration) {
+            error = "cuePoints[" + std::to_string(i) + "] is outside the file";
+            return false;
         }
-    } catch (const std::exception& e) {
-        std::cout << "Warning: Could not load settings, using defaults: " << e.what() << std::endl;
     }
-    return settings;
+
+    RealtimeLogger::Level level;
+    if (!RealtimeLogger::parseLevel(config.logLevel, level)) {
+        error = "unknown logLevel '" + config.logLevel + "'";
+        return false;
+    }
+    return true;
 }
 
-double getAudioFileSampleRate(const std::string& filePath) {
-    try {
-        auto fileStream = std::make_shared<std::ifstream>(filePath, std::ios::binary);
-        if (!fileStream || !fileStream->is_open()) {
-            return 0.0;
-        }
+// Settings a reload can't apply - the audio graph, devices and threads are built from them at startup
+std::vector<std::string> restartOnlyChanges(const Settings& running, const Settings& reloaded) {
+    std::vector<std::string> changed;
+    auto check = [&changed] (const char* name, bool differs) {
+        if (differs) changed.push_back(name);
+    };
 
-        choc::audio::AudioFileFormatList formatList;
-        formatList.addFormat<choc::audio::WAVAudioFileFormat<false>>();
+    check("sampleRate", running.sampleRate != reloaded.sampleRate);
+    check("blockSize", running.blockSize != reloaded.blockSize);
+    check("outputChannels", running.outputChannels != reloaded.outputChannels);
+    check("audioFilePath / replicaPaths", running.audioFilePath != reloaded.audioFilePath
+                                              || running.replicaPaths != reloaded.replicaPaths);
+    check("audioBackend", running.audioBackend != reloaded.audioBackend);
+    check("preferredAudioInterface", running.preferredAudioInterface != reloaded.preferredAudioInterface);
+    check("ltc*", running.ltcEnabled != reloaded.ltcEnabled || running.ltcFrameRate != reloaded.ltcFrameRate
+                      || running.ltcDropFrame != reloaded.ltcDropFrame || running.ltcLevelDb != reloaded.ltcLevelDb);
+    check("mtc* / midiClock*", running.mtcEnabled != reloaded.mtcEnabled || running.mtcFrameRate != reloaded.mtcFrameRate
+                                   || running.mtcDropFrame != reloaded.mtcDropFrame
+                                   || running.midiClockEnabled != reloaded.midiClockEnabled
+                                   || running.midiClockBpm != reloaded.midiClockBpm);
+    check("midiDevicePatterns", running.midiDevicePatterns != reloaded.midiDevicePatterns);
+    check("metrics*", running.metricsEnabled != reloaded.metricsEnabled || running.metricsAddress != reloaded.metricsAddress);
+    check("logTarget", running.logTarget != reloaded.logTarget);
+    check("ioUring / directIO / readAheadKiB / readsInFlight / dropPlayedCache / loaderChunkFrames",
+          running.ioUring != reloaded.ioUring || running.directIO != reloaded.directIO
+              || running.readAheadKiB != reloaded.readAheadKiB || running.readsInFlight != reloaded.readsInFlight
+              || running.dropPlayedCache != reloaded.dropPlayedCache || running.loaderChunkFrames != reloaded.loaderChunkFrames);
+    check("bufferMinSeconds / bufferMaxSeconds", running.bufferMinSeconds != reloaded.bufferMinSeconds
+                                                     || running.bufferMaxSeconds != reloaded.bufferMaxSeconds);
+    check("lockMemory / loader*", running.lockMemory != reloaded.lockMemory || running.loaderCpu != reloaded.loaderCpu
+                                      || running.loaderPriority != reloaded.loaderPriority);
+    return changed;
+}
 
-        auto fileReader = formatList.createReader(fileStream);
-        if (!fileReader) {
-            return 0.0;
+void printRenderUsage() {
+    std::cout << "Usage: consoleAudioPlayer --render out.wav [options]" << std::endl;
+    std::cout << "  --input FILE        Audio file (default: audioFilePath from the config)" << std::endl;
+    std::cout << "  --sample-rate HZ    Output sample rate (default: sampleRate from the config)" << std::endl;
+    std::cout << "  --block-size N      Frames per processBlock() call, 1-16384 (default: blockSize)" << std::endl;
+    std::cout << "  --channels N        Output channels, 1-64 (default: outputChannels)" << std::endl;
+    std::cout << "  --seconds S         Length to render (default: one pass of the file)" << std::endl;
+    std::cout << "  --seek AT:TO        At output time AT seconds, jump to file time TO (repeatable)" << std::endl;
+    std::cout << "  --realtime          Pace blocks at real time with the loader thread" << std::endl;
+}
+
+constexpr uint32_t maxRenderBlockSize = 16384;
+constexpr uint32_t maxRenderChannels = 64;
+
+// Digits only - std::stoul takes "-1" and wraps it to 4G
+uint32_t parseCount(const std::string& text) {
+    size_t used = 0;
+    unsigned long value = !text.empty() && std::isdigit((unsigned char)text[0]) ? std::stoul(text, &used) : 0;
+    if (used == 0 || used != text.size() || value > UINT32_MAX) {
+        throw std::invalid_argument(text);
+    }
+    return (uint32_t)value;
+}
+
+// Fills 'options' from the command line; false = not a render invocation or bad arguments
+bool parseRenderOptions(int argc, char* argv[], const Settings& settings, OfflineRenderer::Options& options, bool& isRender) {
+    options.inputPath = settings.audioFilePath;
+    options.sampleRate = settings.sampleRate;
+    options.blockSize = (uint32_t)settings.blockSize;
+    options.numChannels = (uint32_t)settings.outputChannels;
+    isRender = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        try {
+            if (arg == "--render" && hasValue) {
+                isRender = true;
+                options.outputPath = argv[++i];
+            } else if (arg == "--input" && hasValue) {
+                options.inputPath = argv[++i];
+            } else if (arg == "--sample-rate" && hasValue) {
+                options.sampleRate = std::stod(argv[++i]);
+            } else if (arg == "--block-size" && hasValue) {
+                options.blockSize = parseCount(argv[++i]);
+            } else if (arg == "--channels" && hasValue) {
+                options.numChannels = parseCount(argv[++i]);
+            } else if (arg == "--seconds" && hasValue) {
+                options.durationSeconds = std::stod(argv[++i]);
+            } else if (arg == "--seek" && hasValue) {
+                std::string value = argv[++i];
+                auto colon = value.find(':');
+                if (colon == std::string::npos) {
+                    std::cerr << "Error: --seek expects AT:TO, got " << value << std::endl;
+                    return false;
+                }
+                options.seeks.push_back({ std::stod(value.substr(0, colon)), std::stod(value.substr(colon + 1)) });
+            } else if (arg == "--realtime") {
+                options.realtime = true;
+            } else {
+                std::cerr << "Error: unknown or incomplete argument " << arg << std::endl;
+                return false;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Error: invalid value for " << arg << std::endl;
+            return false;
         }
+    }
 
-        double rate = fileReader->getProperties().sampleRate;
-        return rate;
-    } catch (const std::exception& e) {
-        std::cout << "Warning: Could not read file sample rate: " << e.what() << std::endl;
-        return 0.0;
+    if (!isRender && argc > 1) {
+        std::cerr << "Error: these options only apply with --render" << std::endl;
+        return false;
     }
+
+    // Also catches the config defaults, which are cast from plain ints
+    if (isRender && (options.blockSize == 0 || options.blockSize > maxRenderBlockSize)) {
+        std::cerr << "Error: block size must be 1-" << maxRenderBlockSize << ", got " << options.blockSize << std::endl;
+        return false;
+    }
+    if (isRender && (options.numChannels == 0 || options.numChannels > maxRenderChannels)) {
+        std::cerr << "Error: channel count must be 1-" << maxRenderChannels << ", got " << options.numChannels << std::endl;
+        return false;
+    }
+
+    return true;
 }
 
-// Global context for JACK callback
-struct JackAudioContext {
+// Global context for the audio callback
+struct AudioContext {
     BufferedAudioFilePlayer* audioPlayer = nullptr;
-    jack_port_t** outputPorts = nullptr;
-    int numOutputChannels = 0;
-    jack_client_t* client = nullptr;
+    AudioBackend* backend = nullptr;
     uint64_t fileDurationFrames = 0;  // File duration in output sample rate
     std::atomic<uint64_t> lastKnownPosition{0};  // Cached position from file
-    jack_port_t* midiInputPort = nullptr;  // MIDI input for control
+    LtcGenerator* ltcGenerator = nullptr;  // Optional LTC output
+    MidiTimecodeOutput* midiTimecode = nullptr;  // Optional MTC / MIDI clock output
+
+    MidiMapping* midiMapping = nullptr;    // Learn mode (the bindings are in the live config)
+    RcuPointer<LiveConfig>* liveConfig = nullptr;  // Hot-reloadable settings
+    int controlNotifyFd = -1;              // eventfd that wakes the main thread's reactor
+
+    // Telemetry
+    std::atomic<uint64_t> processCycles{0};
+    std::atomic<uint64_t> firstCycleTime{0};  // StartupTimer::now() of the first callback
+    CallbackProfiler profiler;  // Per-stage callback timing vs. the period budget
+
+    TransportController* transport = nullptr;  // Control thread's state machine (the callback only reads the zero hold)
 
     // Transport control flags (set in audio callback, handled in main thread)
     std::atomic<bool> requestPlay{false};
     std::atomic<bool> requestStop{false};
+    std::atomic<bool> requestPause{false};  // The callback has already silenced the player
+    std::atomic<int> requestCue{-1};
+    std::atomic<int> requestCueStep{0};  // +1 next cue point, -1 previous, 0 = none
+    std::atomic<float> requestSeekSeconds{0.0f};  // Relative seek, 0 = none
 };
 
-// JACK audio process callback - runs in realtime thread
-int jackProcessCallback(jack_nframes_t nframes, void* arg) {
-    auto* ctx = static_cast<JackAudioContext*>(arg);
-    if (!ctx || !ctx->audioPlayer) return 0;
-
-    // Handle MIDI input (if port exists)
-    if (ctx->midiInputPort) {
-        void* midiBuffer = jack_port_get_buffer(ctx->midiInputPort, nframes);
-        jack_nframes_t eventCount = jack_midi_get_event_count(midiBuffer);
-
-        for (jack_nframes_t i = 0; i < eventCount; i++) {
-            jack_midi_event_t event;
-            if (jack_midi_event_get(&event, midiBuffer, i) == 0) {
-                // Parse MIDI CC messages (status byte 0xB0-0xBF)
-                if (event.size >= 3 && (event.buffer[0] & 0xF0) == 0xB0) {
-                    uint8_t ccNumber = event.buffer[1];
-                    uint8_t ccValue = event.buffer[2];
-                    float normalizedValue = ccValue / 127.0f;
-
-                    // Debug MIDI (disabled - enable if debugging MIDI issues)
-                    // printf("[MIDI] CC%d = %d (%.2f)\n", ccNumber, ccValue, normalizedValue);
-
-                    // Handle CC1, CC2, CC3
-                    switch (ccNumber) {
-                        case 1: // Play
-                            if (normalizedValue > 0.5f) {
-                                ctx->requestPlay.store(true, std::memory_order_release);
-                            }
-                            break;
-                        case 2: // Stop/Pause (toggle behavior)
-                            if (normalizedValue > 0.5f) {
-                                // If playing -> pause, if paused -> stop and reset
-                                if (ctx->audioPlayer->isStillPlaying()) {
-                                    ctx->audioPlayer->pause();
-                                    jack_transport_stop(ctx->client);
-                                } else {
-                                    ctx->requestStop.store(true, std::memory_order_release);
-                                }
-                            }
-                            break;
-                        case 3: // Volume
-                            ctx->audioPlayer->setGain(normalizedValue);
-                            break;
-                    }
+// Apply one incoming MIDI message. Called from the process callback at the
+// event's in-block position, between rendered sub-blocks.
+void handleMidiEvent(AudioContext* ctx, const LiveConfig& config, const MidiInputEvent& event) {
+    // Learn mode swallows the message so it doesn't also trigger its current binding
+    if (ctx->midiMapping->captureIfLearning(event.data, event.size)) {
+        ControlReactor::notify(ctx->controlNotifyFd);
+        return;
+    }
+
+    MidiControl control = config.midiTable.lookup(event.data, event.size);
+
+    // Debug MIDI - shown with "logLevel": "debug"
+    RT_LOG_DEBUG("[MIDI] %s = %.2f @ %u", MidiMapping::actionName(control.action), control.value, event.frame);
+
+    // Play and pause land on the event's sample (play only once paused, or stopped
+    // and prerolled) and ramp over a few ms. Stop, seeks and cue jumps need the
+    // loader to refill, so they're handed to the main thread and take effect when
+    // it has - stop still silences the output here.
+    switch (control.action) {
+        case MidiAction::none:
+            break;
+        case MidiAction::play:
+            if (control.pressed) {
+                ctx->transport->playFromCallback();
+                ctx->requestPlay.store(true, std::memory_order_release);
+            }
+            break;
+        case MidiAction::pause:
+            if (control.pressed) {
+                ctx->audioPlayer->pause();  // Here, so it lands on the event's sample
+                ctx->requestPause.store(true, std::memory_order_release);
+            }
+            break;
+        case MidiAction::togglePause:
+            if (control.pressed) {
+                if (ctx->audioPlayer->isStillPlaying()) {
+                    ctx->audioPlayer->pause();
+                    ctx->requestPause.store(true, std::memory_order_release);
+                } else {
+                    ctx->transport->playFromCallback();
+                    ctx->requestPlay.store(true, std::memory_order_release);
                 }
             }
+            break;
+        case MidiAction::pauseOrStop:
+            if (control.pressed) {
+                // If playing -> pause, if paused -> stop and reset
+                if (ctx->audioPlayer->isStillPlaying()) {
+                    ctx->audioPlayer->pause();
+                    ctx->requestPause.store(true, std::memory_order_release);
+                } else {
+                    ctx->requestStop.store(true, std::memory_order_release);
+                }
+            }
+            break;
+        case MidiAction::stop:
+            if (control.pressed) {
+                ctx->audioPlayer->pause();
+                ctx->requestStop.store(true, std::memory_order_release);
+            }
+            break;
+        case MidiAction::gain:
+            ctx->audioPlayer->setGain(std::min(control.value, config.gainLimit));
+            break;
+        case MidiAction::seek:
+            if (control.pressed) {
+                ctx->requestSeekSeconds.store(control.parameter, std::memory_order_release);
+            }
+            break;
+        case MidiAction::cue:
+            if (control.pressed) {
+                ctx->requestCue.store((int)control.parameter, std::memory_order_release);
+            }
+            break;
+        case MidiAction::next:
+        case MidiAction::previous:
+            if (control.pressed) {
+                ctx->requestCueStep.store(control.action == MidiAction::next ? 1 : -1, std::memory_order_release);
+            }
+            break;
+    }
+
+    // Wake the main thread to finish anything it owns (seeks, play/stop from stopped)
+    if (control.pressed && control.action != MidiAction::none && control.action != MidiAction::gain) {
+        ControlReactor::notify(ctx->controlNotifyFd);
+    }
+}
+
+// Audio process callback - runs on the backend's realtime thread
+void processAudio(AudioContext* ctx, AudioProcessBlock& block) {
+    if (!ctx || !ctx->audioPlayer) return;
+
+    CallbackProfiler::Cycle cycle;
+    if (ctx->processCycles.fetch_add(1, std::memory_order_relaxed) == 0) {
+        ctx->firstCycleTime.store(StartupTimer::now(), std::memory_order_release);
+        ControlReactor::notify(ctx->controlNotifyFd);  // For the startup report
+    }
+
+    // One config snapshot for the whole cycle, released by quiescent() below
+    const LiveConfig& config = *ctx->liveConfig->read();
+
+    uint32_t nframes = block.numFrames;
+    const auto& outputView = block.output;
+    uint64_t blockStartFrame = ctx->audioPlayer->getCurrentOutputFrame();
+
+    // Render up to each MIDI event's timestamp, apply it, then carry on - so
+    // control changes land on the exact sample instead of the block boundary
+    uint32_t renderedFrames = 0;
+    for (uint32_t i = 0; i < block.numMidiEvents; i++) {
+        const auto& event = block.midiEvents[i];
+
+        uint32_t eventFrame = std::min(event.frame, nframes);
+        if (eventFrame > renderedFrames) {
+            cycle.lap(CallbackProfiler::midiStage);
+            ctx->audioPlayer->processBlock(outputView.getFrameRange({ renderedFrames, eventFrame }));
+            cycle.lap(CallbackProfiler::renderStage);
+            renderedFrames = eventFrame;
         }
+        handleMidiEvent(ctx, config, event);
     }
+    cycle.lap(CallbackProfiler::midiStage);
 
-    // Get JACK output buffers (raw float* pointers)
-    float* outputBuffers[ctx->numOutputChannels];
-    for (int ch = 0; ch < ctx->numOutputChannels; ch++) {
-        outputBuffers[ch] = static_cast<float*>(jack_port_get_buffer(ctx->outputPorts[ch], nframes));
+    // Call our audio processing for the rest of the block
+    if (renderedFrames < nframes) {
+        ctx->audioPlayer->processBlock(outputView.getFrameRange({ renderedFrames, nframes }));
     }
+    cycle.lap(CallbackProfiler::renderStage);
 
-    // Wrap JACK buffers in CHOC's BufferView (zero-copy)
-    auto outputView = choc::buffer::createChannelArrayView(outputBuffers,
-                                                            (choc::buffer::ChannelCount)ctx->numOutputChannels,
-                                                            (choc::buffer::FrameCount)nframes);
+    // Timecode follows what was actually played this block (not rolling while paused, stopped or underrunning)
+    bool rolling = ctx->audioPlayer->getCurrentOutputFrame() == blockStartFrame + nframes;
 
-    // Call our audio processing
-    ctx->audioPlayer->processBlock(outputView);
+    if (ctx->ltcGenerator && block.ltcOutput) {
+        ctx->ltcGenerator->renderBlock(block.ltcOutput, nframes, blockStartFrame, rolling);
+    }
 
-    // Cache current position for timebase callback (derived from fileReadPosition)
-    ctx->lastKnownPosition.store(ctx->audioPlayer->getCurrentOutputFrame(), std::memory_order_release);
+    if (ctx->midiTimecode && block.midiOutput) {
+        ctx->midiTimecode->renderBlock(block.midiOutput, nframes, blockStartFrame, rolling);
+    }
+    cycle.lap(CallbackProfiler::timecodeStage);
 
-    return 0;
-}
+    // Cache current position for the transport - what this cycle emitted, traced back through the
+    // FIFO to the file. Downstream latency is for each client to compensate, as JACK expects.
+    ctx->lastKnownPosition.store(ctx->audioPlayer->getEmittedOutputFrame(), std::memory_order_release);
+    cycle.lap(CallbackProfiler::positionStage);
 
-// JACK timebase callback - called after process callback to update position
-// As timebase master, we write our current audio position to JACK Transport
-void jackTimebaseCallback(jack_transport_state_t state, jack_nframes_t nframes,
-                          jack_position_t *pos, int new_pos, void *arg) {
-    auto* ctx = static_cast<JackAudioContext*>(arg);
-    if (!ctx || !ctx->audioPlayer) return;
+    ctx->profiler.record(cycle);
+    ctx->liveConfig->quiescent();
+}
 
-    // If stop was requested, force position to 0 and don't update from audio
-    if (ctx->requestStop.load(std::memory_order_acquire)) {
-        pos->frame = 0;
-        pos->valid = (jack_position_bits_t)0;
-        return;
+// Transport position, asked for by the backend after each process callback.
+// As timebase master, this is what JACK Transport reports to everyone else.
+uint64_t transportPosition(AudioContext* ctx) {
+    // Stopped: report exactly 0, whatever the refill is doing
+    if (ctx->transport && ctx->transport->isHoldingAtZero()) {
+        return 0;
     }
 
     // Use cached position (updated by process callback) - safe even during seeks
@@ -277,20 +646,30 @@ void jackTimebaseCallback(jack_transport_state_t state, jack_nframes_t nframes,
         currentAudioFrame = currentAudioFrame % ctx->fileDurationFrames;
     }
 
-    pos->frame = currentAudioFrame;  // Write audio position to JACK (master controls timeline)
-    pos->valid = (jack_position_bits_t)0; // We only provide frame count, no BBT/timecode
+    return currentAudioFrame;
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+    StartupTimer startup;
+
     // Install signal handlers for debugging
     signal(SIGSEGV, signal_handler);
     signal(SIGABRT, signal_handler);
 
+    // SIGINT/SIGTERM are delivered through the control reactor's signalfd. Block them
+    // before any thread exists (JACK, loader) so every thread inherits the mask.
+    sigset_t shutdownSignals;
+    sigemptyset(&shutdownSignals);
+    sigaddset(&shutdownSignals, SIGINT);
+    sigaddset(&shutdownSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &shutdownSignals, nullptr);
+
     std::cout << "CHOC Audio File Player Example" << std::endl;
     std::cout << "==============================" << std::endl;
 
     auto settings = loadSettings();
+    startup.phase("settings");
 
     std::cout << "\nLoaded settings:" << std::endl;
     std::cout << "  Sample rate: " << settings.sampleRate << " Hz" << std::endl;
@@ -298,6 +677,32 @@ int main()
     std::cout << "  Output channels: " << settings.outputChannels << std::endl;
     std::cout << "  Audio file path: " << settings.audioFilePath << std::endl << std::endl;
 
+    // Realtime-safe logging for the audio and loader threads
+    auto& logger = RealtimeLogger::get();
+    RealtimeLogger::Level logLevel;
+    if (RealtimeLogger::parseLevel(settings.logLevel, logLevel)) {
+        logger.setMinimumLevel(logLevel);
+    } else {
+        std::cout << "Warning: Unknown logLevel '" << settings.logLevel << "', using info" << std::endl;
+    }
+    if (!logger.start(settings.logTarget)) {
+        std::cerr << "Warning: " << logger.getErrorMessage() << " - logging to stdout" << std::endl;
+        logger.start("stdout");
+    }
+
+    // Headless render: no JACK, no keyboard - process the file into a WAV and exit
+    OfflineRenderer::Options renderOptions;
+    bool isRender = false;
+    if (!parseRenderOptions(argc, argv, settings, renderOptions, isRender)) {
+        printRenderUsage();
+        return 1;
+    }
+    if (isRender) {
+        int result = OfflineRenderer(renderOptions).run();
+        logger.stop();
+        return result;
+    }
+
     auto logMessage = [] (const std::string& message) {
         std::cout << "[Audio] " << message << std::endl;
         std::cout.flush();
@@ -308,134 +713,228 @@ int main()
         return 1;
     }
 
-    double fileSampleRate = getAudioFileSampleRate(settings.audioFilePath);
-    double preferredSampleRate = (fileSampleRate > 0) ? fileSampleRate : settings.sampleRate;
-
-    std::cout << "  File sample rate: " << fileSampleRate << " Hz" << std::endl << std::endl;
-
-    // Initialize JACK client
-    jack_status_t jackStatus;
-    jack_client_t* jackClient = jack_client_open("consoleAudioPlayer", JackNullOption, &jackStatus);
+    // The file is opened and parsed once, here. Until the backend reports its
+    // rate the player assumes it can run at the file's own rate.
+    IoUringStreamBuf::Options readOptions;
+    readOptions.ioUring = settings.ioUring;
+    readOptions.directIO = settings.directIO;
+    readOptions.dropBehind = settings.dropPlayedCache;
+    readOptions.blockBytes = settings.readAheadKiB > 0 ? (uint32_t)std::max(settings.readAheadKiB, 4) * 1024 : 0;
+    readOptions.blocksInFlight = (uint32_t)std::max(settings.readsInFlight, 2);
+    auto audioFilePlayer = std::make_unique<BufferedAudioFilePlayer>(settings.audioFilePath, 0.0, readOptions);
 
-    if (!jackClient) {
-        std::cerr << "Failed to open JACK client. Is JACK server running?" << std::endl;
-        std::cerr << "Try: jackd -d alsa -r 48000 -p 256" << std::endl;
+    if (!audioFilePlayer->isLoaded()) {
+        std::cerr << "Error loading audio file: " << audioFilePlayer->getErrorMessage() << std::endl;
+        return 1;
+    }
+    audioFilePlayer->setBufferLimits(settings.bufferMinSeconds, settings.bufferMaxSeconds);
+    audioFilePlayer->setChunkFrames((uint32_t)std::max(settings.loaderChunkFrames, 0));
+    audioFilePlayer->setReplicaPaths(settings.replicaPaths);
+    startup.phase("file open");
+
+    // Audio backend - the JACK server by default; "alsa" plays straight into a
+    // device (preferredAudioInterface, e.g. "hw:0"), "null" runs on a timer
+    auto backend = AudioBackend::create(settings.audioBackend);
+    if (!backend) {
+        std::cerr << "Error: Unknown audioBackend '" << settings.audioBackend << "' (use jack, alsa or null)" << std::endl;
         return 1;
     }
 
+    AudioBackend::Options backendOptions;
+    backendOptions.device = settings.preferredAudioInterface;
+    backendOptions.sampleRate = audioFilePlayer->getFileSampleRate();  // Run at the file's rate where the backend lets us
+    backendOptions.blockSize = (uint32_t)settings.blockSize;
+    backendOptions.numOutputChannels = (uint32_t)settings.outputChannels;
+    backendOptions.midiInput = true;
+    backendOptions.midiOutput = settings.mtcEnabled || settings.midiClockEnabled;
+    backendOptions.ltcOutput = settings.ltcEnabled;
+
+    // Connecting to the JACK server (or opening the device) takes tens of ms - do
+    // it on another thread and buffer the start of the file meanwhile
+    uint64_t backendOpenNs = 0;
+    auto backendOpened = std::async(std::launch::async, [&backend, &backendOptions, &backendOpenNs] {
+        uint64_t started = StartupTimer::now();
+        bool opened = backend->open(backendOptions);
+        backendOpenNs = StartupTimer::now() - started;
+        return opened;
+    });
+
+    if (settings.lockMemory) {
+        audioFilePlayer->prefaultBuffers();
+    }
+    audioFilePlayer->prefill(settings.startupPrefillSeconds);
+    startup.phase("prefill");
 
-    jack_nframes_t jackSampleRate = jack_get_sample_rate(jackClient);
-    jack_nframes_t jackBlockSize = jack_get_buffer_size(jackClient);
+    bool backendOk = backendOpened.get();
+    startup.phase("waiting for backend");
+    startup.parallel(std::string(backend->getName()) + " open", backendOpenNs);
 
-    // Create JACK output ports
-    jack_port_t* outputPorts[settings.outputChannels];
-    for (int ch = 0; ch < settings.outputChannels; ch++) {
-        std::string portName = "output_" + std::to_string(ch + 1);
-        outputPorts[ch] = jack_port_register(jackClient, portName.c_str(),
-                                              JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        if (!outputPorts[ch]) {
-            std::cerr << "Failed to register JACK output port " << ch << std::endl;
-            jack_client_close(jackClient);
-            return 1;
-        }
+    if (!backendOk) {
+        std::cerr << backend->getErrorMessage() << std::endl;
+        return 1;
     }
 
-    // Create JACK MIDI input port for control
-    jack_port_t* midiInputPort = jack_port_register(jackClient, "midi_in",
-                                                      JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
-    if (!midiInputPort) {
-        std::cerr << "Warning: Failed to register JACK MIDI input port (MIDI control disabled)" << std::endl;
+    // The backend couldn't run at the file's rate - what was buffered is at the wrong rate
+    double outputSampleRate = backend->getSampleRate();
+    if (std::abs(outputSampleRate - audioFilePlayer->getOutputSampleRate()) > 0.1) {
+        audioFilePlayer->setOutputSampleRate(outputSampleRate);
+        if (settings.lockMemory) {
+            audioFilePlayer->prefaultBuffers();
+        }
+        audioFilePlayer->prefill(settings.startupPrefillSeconds);
+        startup.phase("prefill at output rate");
     }
 
-    auto audioFilePlayer = std::make_unique<BufferedAudioFilePlayer>(settings.audioFilePath, jackSampleRate);
-
-    if (!audioFilePlayer->isLoaded()) {
-        std::cerr << "Error loading audio file: " << audioFilePlayer->getErrorMessage() << std::endl;
+    // Control reactor - the main thread sleeps here until something happens
+    ControlReactor reactor;
+    if (!reactor.isValid()) {
         return 1;
     }
-
-    // Pre-fill buffer before starting audio callbacks
-    audioFilePlayer->startPlayback();
+    int audioNotifyFd = reactor.createNotifier();  // Audio callback and loader -> main thread
+    audioFilePlayer->setLoopCallback([audioNotifyFd] { ControlReactor::notify(audioNotifyFd); });
+    audioFilePlayer->setBufferedCallback([audioNotifyFd] { ControlReactor::notify(audioNotifyFd); });
+
+    // Loader thread: pinned and prioritised once the backend has started and knows
+    // what priority its own thread actually got (below)
+    std::promise<pthread_t> loaderThreadStarted;
+    auto loaderThread = loaderThreadStarted.get_future();
+    audioFilePlayer->setLoaderThreadInit([&loaderThreadStarted] {
+        RealtimeSetup::prefaultStack();
+        loaderThreadStarted.set_value(pthread_self());
+    });
+
+    // Start as soon as the minimum is buffered; the loader fills the rest while we play
+    audioFilePlayer->startPlayback(true, settings.startupPrefillSeconds);
+    startup.phase("loader start");
 
     // Calculate file duration in output sample rate (for looping)
     double fileDuration = (double)audioFilePlayer->getTotalFrames() / audioFilePlayer->getFileSampleRate();
-    uint64_t fileDurationFrames = (uint64_t)(fileDuration * jackSampleRate);
-
-    std::cout << "Audio: " << settings.outputChannels << "ch @ " << jackSampleRate << " Hz ("
-              << std::fixed << std::setprecision(1) << fileDuration << "s)" << std::endl;
-
-    // Setup JACK callback context
-    JackAudioContext jackContext;
-    jackContext.audioPlayer = audioFilePlayer.get();
-    jackContext.outputPorts = outputPorts;
-    jackContext.numOutputChannels = settings.outputChannels;
-    jackContext.client = jackClient;
-    jackContext.fileDurationFrames = fileDurationFrames;
-    jackContext.midiInputPort = midiInputPort;
-
-    // Register JACK process callback
-    if (jack_set_process_callback(jackClient, jackProcessCallback, &jackContext) != 0) {
-        std::cerr << "Failed to set JACK process callback" << std::endl;
-        jack_client_close(jackClient);
-        return 1;
+    uint64_t fileDurationFrames = (uint64_t)(fileDuration * outputSampleRate);
+
+    std::cout << "Audio: " << settings.outputChannels << "ch @ " << outputSampleRate << " Hz via "
+              << backend->getName() << " (" << std::fixed << std::setprecision(1) << fileDuration << "s)" << std::endl;
+
+    // LTC generator - precomputes frames ahead of the play head on its own thread
+    std::unique_ptr<LtcGenerator> ltcGenerator;
+    if (backend->hasLtcOutput()) {
+        auto ltcRate = TimecodeRate::fromSettings(settings.ltcFrameRate, settings.ltcDropFrame);
+        ltcGenerator = std::make_unique<LtcGenerator>(outputSampleRate, ltcRate, settings.ltcLevelDb);
+        ltcGenerator->setTimelineLength(fileDurationFrames);
+        ltcGenerator->start([player = audioFilePlayer.get()] { return player->getCurrentOutputFrame(); });
+        std::cout << "LTC: ltc_out @ "
+                  << (double)ltcRate.numerator / ltcRate.denominator << " fps"
+                  << (ltcRate.dropFrame ? " DF" : "") << std::endl;
     }
 
-    // Register as JACK Transport timebase master
-    if (jack_set_timebase_callback(jackClient, 0, jackTimebaseCallback, &jackContext) != 0) {
-        std::cerr << "Failed to set JACK timebase callback" << std::endl;
-        jack_client_close(jackClient);
-        return 1;
+    // MTC / MIDI clock - rendered entirely inside the process callback
+    std::unique_ptr<MidiTimecodeOutput> midiTimecode;
+    if (backend->hasMidiOutput()) {
+        auto mtcRate = TimecodeRate::fromSettings(settings.mtcFrameRate, settings.mtcDropFrame);
+        midiTimecode = std::make_unique<MidiTimecodeOutput>(outputSampleRate, mtcRate, settings.mtcEnabled,
+                                                            settings.midiClockEnabled, settings.midiClockBpm);
+        midiTimecode->setTimelineLength(fileDurationFrames);
+        std::cout << "MIDI out: midi_out"
+                  << (settings.mtcEnabled ? " [MTC]" : "")
+                  << (settings.midiClockEnabled ? " [clock]" : "") << std::endl;
     }
 
-    // Activate JACK client
-    if (jack_activate(jackClient) != 0) {
-        std::cerr << "Failed to activate JACK client" << std::endl;
-        jack_client_close(jackClient);
+    // Setup audio callback context
+    AudioContext audioContext;
+    audioContext.audioPlayer = audioFilePlayer.get();
+    audioContext.backend = backend.get();
+    audioContext.fileDurationFrames = fileDurationFrames;
+    audioContext.ltcGenerator = ltcGenerator.get();
+    audioContext.midiTimecode = midiTimecode.get();
+    audioContext.controlNotifyFd = audioNotifyFd;
+    audioContext.profiler.setBudget(backend->getBlockSize(), outputSampleRate);
+
+    // MIDI mapping - either from the config or the original CC1/CC2/CC3 layout. Held to the
+    // same checks as a reload; what a reload would reject falls back to the defaults.
+    auto startupConfig = std::make_unique<LiveConfig>(makeLiveConfig(settings));
+    std::string configError;
+    if (!validateLiveConfig(*startupConfig, fileDuration, configError)) {
+        std::cout << "Warning: " << configError << " - using the default gain limit, cue points, MIDI mapping and log level"
+                  << std::endl;
+        const Settings defaults;
+        settings.gainLimit = defaults.gainLimit;
+        settings.cuePoints = defaults.cuePoints;
+        settings.midiCueBaseNote = defaults.midiCueBaseNote;
+        settings.midiMapping = defaults.midiMapping;
+        settings.logLevel = defaults.logLevel;
+        startupConfig = std::make_unique<LiveConfig>(makeLiveConfig(settings));
+    }
+    RcuPointer<LiveConfig> liveConfig(std::move(startupConfig));
+    audioContext.liveConfig = &liveConfig;
+
+    MidiMapping midiMapping;
+    audioContext.midiMapping = &midiMapping;
+
+    // Play / pause / stop / seek - one state machine on this thread; prerolls and seeks
+    // wait for the same amount of audio that startup buffers
+    TransportController transport(reactor, *audioFilePlayer, *backend, ltcGenerator.get(), settings.startupPrefillSeconds);
+    audioContext.transport = &transport;
+    startup.phase("timecode and control setup");
+
+    // Keep the profiler's period budget in step with the backend
+    backend->setBlockSizeCallback([&audioContext, outputSampleRate] (uint32_t frames) {
+        audioContext.profiler.setBudget(frames, outputSampleRate);
+    });
+
+    // The device went away under the audio thread - the control thread reports it and exits
+    backend->setFailureCallback([audioNotifyFd] { ControlReactor::notify(audioNotifyFd); });
+
+    // Publish our position as transport master
+    backend->setTimebaseSource([&audioContext] { return transportPosition(&audioContext); });
+
+    // MIDI hot-plug handling (JACK only) - notification callbacks must be registered before activation
+    std::unique_ptr<MidiAutoConnector> midiConnector;
+    auto* jackBackend = dynamic_cast<JackBackend*>(backend.get());
+    if (jackBackend && jackBackend->getMidiInputPort()) {
+        midiConnector = std::make_unique<MidiAutoConnector>(jackBackend->getClient(), jackBackend->getMidiInputPort(),
+                                                            settings.midiDevicePatterns);
+        if (!midiConnector->registerCallbacks()) {
+            std::cerr << "Warning: Failed to set JACK port callbacks (MIDI hot-plug disabled)" << std::endl;
+        }
+    }
+
+    // Start processing (JACK: activate and auto-connect to system playback)
+    if (!backend->start([&audioContext] (AudioProcessBlock& block) { processAudio(&audioContext, block); })) {
+        std::cerr << backend->getErrorMessage() << std::endl;
+        audioFilePlayer->stopLoading();
         return 1;
     }
+    startup.phase(std::string(backend->getName()) + " start");
+
+    // Below the audio thread, optionally on its own core. The loader's first tick is 10 ms away at most.
+    if (loaderThread.wait_for(std::chrono::seconds(1)) == std::future_status::ready) {
+        int loaderPriority = RealtimeSetup::loaderPriorityBelow(backend->getRealtimePriority(), settings.loaderPriority);
+        RT_LOG_INFO("Loader thread: %s",
+                    RealtimeSetup::configureThread(loaderThread.get(), settings.loaderCpu, loaderPriority).c_str());
+    } else {
+        std::cout << "Warning: loader thread not running - left at default priority" << std::endl;
+    }
 
-    // Auto-connect JACK ports to system playback
-    const char** systemPorts = jack_get_ports(jackClient, "system:playback_", nullptr, JackPortIsInput);
-    if (systemPorts) {
-        for (int ch = 0; ch < settings.outputChannels && systemPorts[ch]; ch++) {
-            std::string ourPort = "consoleAudioPlayer:output_" + std::to_string(ch + 1);
-            jack_connect(jackClient, ourPort.c_str(), systemPorts[ch]);
-        }
-        jack_free(systemPorts);
-    }
-
-    // Auto-connect MIDI input to devices with "pico" or "CircuitPython" in name
-    if (midiInputPort) {
-        const char** midiPorts = jack_get_ports(jackClient, nullptr, JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput);
-        if (midiPorts) {
-            bool connected = false;
-            for (int i = 0; midiPorts[i] != nullptr; i++) {
-                std::string portName = midiPorts[i];
-                // Check if port name contains "pico" or "CircuitPython" (case-insensitive)
-                std::string lowerName = portName;
-                std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
-
-                if (lowerName.find("pico") != std::string::npos ||
-                    lowerName.find("circuitpython") != std::string::npos) {
-                    if (jack_connect(jackClient, midiPorts[i], jack_port_name(midiInputPort)) == 0) {
-                        std::cout << "✓ MIDI: " << midiPorts[i] << std::endl;
-                        connected = true;
-                        break; // Connect to first matching device
-                    }
-                }
-            }
-            if (!connected) {
-                std::cout << "⚠ No MIDI device found" << std::endl;
-            }
-            jack_free(midiPorts);
-        }
+    // Lock once the FIFO, the decode buffer and every thread's stack exist - they're
+    // prefaulted, so this only pins them (and the code and libraries) in RAM
+    if (settings.lockMemory) {
+        std::string report;
+        RealtimeSetup::lockMemory(report);
+        std::cout << "Realtime: " << report << std::endl;
+        startup.phase("memory lock");
+    }
+
+    // Auto-connect MIDI input to a matching controller, now and whenever one is plugged in
+    if (midiConnector) {
+        midiConnector->start();
     }
 
     std::cout << "Playing file: " << settings.audioFilePath << "..." << std::endl;
 
     // Start JACK Transport rolling
-    jack_transport_start(jackClient);
-    std::cout << "JACK Transport started" << std::endl;
+    backend->transportStart();
+    if (jackBackend) {
+        std::cout << "JACK Transport started" << std::endl;
+    }
 
     // Setup keyboard input
     auto termState = setupNonBlockingInput();
@@ -446,63 +945,200 @@ int main()
     std::cout << "  F     - Skip forward 10 seconds" << std::endl;
     std::cout << "  D     - Skip forward 30 seconds" << std::endl;
     std::cout << "  G     - Skip forward 60 seconds" << std::endl;
+    std::cout << "  B     - Skip back 10 seconds" << std::endl;
+    std::cout << "  [ ]   - Previous / next cue point" << std::endl;
+    std::cout << "  L     - Learn: bind the next MIDI message to an action" << std::endl;
+    std::cout << "  P     - Print callback timing profile" << std::endl;
     std::cout << "  Q     - Quit" << std::endl << std::endl;
 
-    bool running = true;
-    while (running) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-
-        // Check for keyboard input
-        char key = getKeyPress();
-        if (key != 0) {
-            switch (key) {
-                case ' ': // Space - toggle pause/play
-                    if (audioFilePlayer->isStillPlaying()) {
-                        audioFilePlayer->pause();
-                        jack_transport_stop(jackClient);
-                    } else {
-                        jackContext.requestStop.store(false, std::memory_order_release);  // Clear stop lock
-                        audioFilePlayer->play();
-                        jack_transport_start(jackClient);
-                    }
-                    break;
-
-                case 's':
-                case 'S':
-                    audioFilePlayer->stop();
-                    jackContext.lastKnownPosition.store(0, std::memory_order_release);
-                    jackContext.requestStop.store(true, std::memory_order_release);  // Lock at 0
-                    jack_transport_locate(jackClient, 0);
-                    jack_transport_stop(jackClient);
-                    break;
-
-                case 'f':
-                case 'F': {
-                    // Seek audio - timebase callback will update JACK automatically
-                    audioFilePlayer->skipForward(10.0);
-                    std::cout << "⏩ Skipped +10s" << std::endl;
-                    break;
-                }
+    std::optional<MidiBinding> learnedBinding;  // Captured by learn mode, waiting for an action key
 
-                case 'd':
-                case 'D': {
-                    audioFilePlayer->skipForward(30.0);
-                    std::cout << "⏩ Skipped +30s" << std::endl;
-                    break;
-                }
+    // Relative seeks, measured from what's audible rather than from how far the loader has read
+    auto seekBy = [&] (double seconds) {
+        transport.seek(audioFilePlayer->getRelativeSeekTarget(seconds, backend->getOutputLatency()));
+    };
+
+    // Cue point jumps play from the cue's exact frame, also from stopped
+    auto seekToCue = [&] (int cueIndex) {
+        const auto& cuePoints = liveConfig.get().cuePoints;
+        if (cueIndex < 0 || cueIndex >= (int)cuePoints.size()) {
+            std::cout << "⚠ Cue " << (cueIndex + 1) << " is not defined in cuePoints" << std::endl;
+            return;
+        }
+
+        double cueSeconds = cuePoints[cueIndex];
+        transport.seek((uint64_t)std::llround(cueSeconds * audioFilePlayer->getFileSampleRate()), true);
+        std::cout << "⏭  Cue " << (cueIndex + 1) << " (" << std::fixed << std::setprecision(2)
+                  << cueSeconds << "s)" << std::endl;
+    };
+
+    // The first cue point after the play head (direction 1) or the last one before it (-1),
+    // wrapping around. Half a second of slack, so a repeated press moves on. -1 = no cues.
+    auto findCue = [&] (int direction) {
+        const auto& cues = liveConfig.get().cuePoints;
+        double now = (double)audioFilePlayer->getAudibleFileFrame(backend->getOutputLatency())
+                     / audioFilePlayer->getFileSampleRate();
+        int wrapCue = -1, found = -1;
+        for (int i = 0; i < (int)cues.size(); i++) {
+            if (direction > 0) {
+                if (wrapCue < 0 || cues[i] < cues[wrapCue]) wrapCue = i;
+                if (cues[i] > now + 0.5 && (found < 0 || cues[i] < cues[found])) found = i;
+            } else {
+                if (wrapCue < 0 || cues[i] > cues[wrapCue]) wrapCue = i;
+                if (cues[i] < now - 0.5 && (found < 0 || cues[i] > cues[found])) found = i;
+            }
+        }
+        return found >= 0 ? found : wrapCue;
+    };
 
-                case 'g':
-                case 'G': {
-                    audioFilePlayer->skipForward(60.0);
-                    std::cout << "⏩ Skipped +60s" << std::endl;
-                    break;
+    auto handleKey = [&] (char key) {
+        // A learned MIDI message is waiting for its action
+        if (learnedBinding) {
+            static const MidiAction learnActions[] = {
+                MidiAction::play, MidiAction::pause, MidiAction::togglePause, MidiAction::pauseOrStop,
+                MidiAction::stop, MidiAction::gain, MidiAction::next, MidiAction::previous
+            };
+            int choice = key - '1';
+            bool assigned = true;
+
+            if (learnedBinding->action == MidiAction::cue) {
+                // 'C' was pressed - this key is the cue number
+                assigned = choice >= 0 && choice < 9;
+                learnedBinding->parameter = (float)choice;
+            } else if (choice >= 0 && choice < (int)std::size(learnActions)) {
+                learnedBinding->action = learnActions[choice];
+            } else if (key == 'c' || key == 'C') {
+                learnedBinding->action = MidiAction::cue;
+                std::cout << "   Cue number (1-9, other key cancels)" << std::endl;
+                return;
+            } else {
+                // The same jumps as the seek keys
+                double seconds = 0.0;
+                switch (key) {
+                    case 'f': case 'F': seconds = 10.0; break;
+                    case 'd': case 'D': seconds = 30.0; break;
+                    case 'g': case 'G': seconds = 60.0; break;
+                    case 'b': case 'B': seconds = -10.0; break;
+                    default: assigned = false; break;
                 }
+                learnedBinding->action = MidiAction::seek;
+                learnedBinding->parameter = (float)seconds;
+            }
+
+            if (assigned) {
+                // A new snapshot like a reload, so the callback never sees the table change under it
+                auto next = std::make_unique<LiveConfig>(liveConfig.get());
+                MidiMapping::addBinding(next->midiBindings, *learnedBinding);
+                next->midiTable = MidiTable(next->midiBindings);
+                liveConfig.publish(std::move(next));
+                std::cout << "🎹 Mapped. Add to \"midiMapping\" in the config to keep it:" << std::endl;
+                std::cout << "   " << MidiMapping::toJson(*learnedBinding) << std::endl;
+            } else {
+                std::cout << "🎹 Learn cancelled" << std::endl;
+            }
+            learnedBinding.reset();
+            return;
+        }
+
+        switch (key) {
+            case ' ': // Space - toggle pause/play
+                transport.togglePause();
+                break;
+
+            case 's':
+            case 'S':
+                transport.stop();
+                break;
+
+            case 'f':
+            case 'F': {
+                // Seek audio - timebase callback will update JACK automatically
+                seekBy(10.0);
+                std::cout << "⏩ Skipped +10s" << std::endl;
+                break;
+            }
+
+            case 'd':
+            case 'D': {
+                seekBy(30.0);
+                std::cout << "⏩ Skipped +30s" << std::endl;
+                break;
+            }
+
+            case 'g':
+            case 'G': {
+                seekBy(60.0);
+                std::cout << "⏩ Skipped +60s" << std::endl;
+                break;
+            }
 
-                case 'q':
-                case 'Q':
-                    running = false;
-                    break;
+            case 'b':
+            case 'B':
+                seekBy(-10.0);
+                std::cout << "⏪ Skipped -10s" << std::endl;
+                break;
+
+            case '[':
+            case ']': {
+                int cue = findCue(key == ']' ? 1 : -1);
+                if (cue >= 0) {
+                    seekToCue(cue);
+                }
+                break;
             }
+
+            case 'l':
+            case 'L':
+                midiMapping.armLearn();
+                std::cout << "🎹 Learn: move a control or press a pad..." << std::endl;
+                break;
+
+            case 'p':
+            case 'P':
+                std::cout << audioContext.profiler.getReport() << std::flush;
+                break;
+
+            case 'q':
+            case 'Q':
+                reactor.stop();
+                break;
+        }
+    };
+
+    // Keyboard: stdin is non-blocking, so drain everything that's there. A closed
+    // pipe (a supervisor, "echo q | ...") stays readable forever - stop watching it.
+    reactor.onReadable(STDIN_FILENO, [&] {
+        char key;
+        ssize_t n;
+        while ((n = read(STDIN_FILENO, &key, 1)) == 1) {
+            handleKey(key);
+        }
+
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            reactor.remove(STDIN_FILENO);
+            std::cout << "stdin closed - keyboard control off" << std::endl;
+        }
+    });
+
+    // Ctrl+C / SIGTERM - leave the loop so the terminal and JACK are cleaned up
+    reactor.createSignalFd(shutdownSignals, [&] (int) {
+        reactor.stop();
+    });
+
+    // Requests from the audio callback and loop notifications from the loader
+    bool startupReported = false;
+    int exitCode = 0;
+    reactor.onReadable(audioNotifyFd, [&] {
+        if (backend->hasFailed()) {
+            std::cerr << "Error: audio output stopped - " << backend->getErrorMessage() << std::endl;
+            exitCode = 1;
+            reactor.stop();
+            return;
+        }
+
+        if (!startupReported && audioContext.firstCycleTime.load(std::memory_order_acquire) != 0) {
+            startupReported = true;
+            std::cout << startup.getReport(audioContext.firstCycleTime.load(std::memory_order_acquire));
         }
 
         // Check for loop detection from file reader
@@ -511,86 +1147,192 @@ int main()
             // Audio already looped seamlessly, JACK Transport will update automatically
         }
 
-        // Handle MIDI transport requests (from audio callback)
-        if (jackContext.requestPlay.exchange(false, std::memory_order_acquire)) {
-            // If we're coming from stopped state, reset audio position first
-            bool wasStoppedAtZero = jackContext.requestStop.exchange(false, std::memory_order_acq_rel);
-            if (wasStoppedAtZero) {
-                // Reset audio to beginning
-                audioFilePlayer->stop();  // Resets fileReadPosition to 0 and clears buffer
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));  // Let buffer refill from 0
-                std::cout << "▶  Playing from start" << std::endl;
+        // Learn mode captured a message - ask which action it should trigger
+        MidiBinding learned;
+        if (midiMapping.getLearnedMessage(learned)) {
+            learnedBinding = learned;
+            std::cout << "🎹 Learned " << MidiMapping::toJson(learned) << std::endl;
+            std::cout << "   Assign: 1 play, 2 pause, 3 pause/resume, 4 pause/stop, 5 stop, 6 gain, 7 next, 8 previous,"
+                      << " F/D/G/B seek +10/+30/+60/-10s, C cue (other key cancels)" << std::endl;
+        }
+
+        // Handle MIDI relative seeks (from audio callback)
+        float seekSeconds = audioContext.requestSeekSeconds.exchange(0.0f, std::memory_order_acquire);
+        if (seekSeconds != 0.0f) {
+            seekBy(seekSeconds);
+            std::cout << (seekSeconds > 0 ? "⏩" : "⏪") << " Seek " << std::showpos << std::fixed
+                      << std::setprecision(1) << seekSeconds << std::noshowpos << "s" << std::endl;
+        }
+
+        // "next" / "previous" pick the cue point either side of the play head
+        int cueStep = audioContext.requestCueStep.exchange(0, std::memory_order_acquire);
+        if (cueStep != 0) {
+            int cue = findCue(cueStep);
+            if (cue >= 0) {
+                audioContext.requestCue.store(cue, std::memory_order_release);
             }
-            audioFilePlayer->play();
-            jack_transport_start(jackClient);
-        }
-        if (jackContext.requestStop.load(std::memory_order_acquire)) {
-            audioFilePlayer->stop();
-            jackContext.lastKnownPosition.store(0, std::memory_order_release);  // Force position to 0
-
-            // Immediately stop JACK Transport and reset to 0 (before delay, to prevent race)
-            jack_transport_locate(jackClient, 0);
-            jack_transport_stop(jackClient);
-
-            // Brief delay to let buffer refill from position 0 (prevents playing stale data)
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-
-            // Keep position locked at 0
-            jack_transport_locate(jackClient, 0);
-
-            // DON'T clear requestStop flag - keep it set so timebase callback
-            // continues forcing JACK position to EXACTLY 0 (prevents background
-            // fill thread from updating position as it refills buffer).
-            // Flag will be cleared when user presses play.
-        }
-
-        // Periodic MIDI auto-reconnect check (every 5 seconds)
-        static int midiReconnectCount = 0;
-        if (midiInputPort && midiReconnectCount++ % 5000 == 0) {
-            // Check if MIDI port is connected
-            const char** connections = jack_port_get_connections(midiInputPort);
-            if (!connections) {
-                // Not connected - try to find and connect to pico/CircuitPython
-                const char** midiPorts = jack_get_ports(jackClient, nullptr, JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput);
-                if (midiPorts) {
-                    for (int i = 0; midiPorts[i] != nullptr; i++) {
-                        std::string portName = midiPorts[i];
-                        std::string lowerName = portName;
-                        std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
-
-                        if (lowerName.find("pico") != std::string::npos ||
-                            lowerName.find("circuitpython") != std::string::npos) {
-                            if (jack_connect(jackClient, midiPorts[i], jack_port_name(midiInputPort)) == 0) {
-                                break;
-                            }
-                        }
-                    }
-                    jack_free(midiPorts);
+        }
+
+        // Handle MIDI cue triggers (from audio callback)
+        int cueIndex = audioContext.requestCue.exchange(-1, std::memory_order_acquire);
+        if (cueIndex >= 0) {
+            seekToCue(cueIndex);
+        }
+
+        // Handle MIDI transport requests (from audio callback) - a stop before a play, so
+        // "stop, play" in one wakeup plays from the start
+        if (audioContext.requestPause.exchange(false, std::memory_order_acquire)) {
+            transport.pause();
+        }
+        if (audioContext.requestStop.exchange(false, std::memory_order_acquire)) {
+            transport.stop();
+        }
+        if (audioContext.requestPlay.exchange(false, std::memory_order_acquire)) {
+            transport.play();
+        }
+
+        // The loader reports when a preroll or seek has buffered enough
+        transport.update();
+    });
+
+    // Hot reload - parse and validate on this thread, then swap the snapshot the callback reads.
+    // Editors fire several events per save, so wait for them to settle before reading.
+    ConfigWatcher configWatcher;
+    const std::string configPath = getConfigFilePath();
+    int configReloadTimer = reactor.createTimer();
+
+    reactor.onReadable(configReloadTimer, [&] {
+        Settings reloaded;
+        std::string error;
+        if (!parseSettings(configPath, reloaded, error)) {
+            std::cout << "⚠ Config reload rejected: " << error << std::endl;
+            return;
+        }
+
+        auto next = std::make_unique<LiveConfig>(makeLiveConfig(reloaded));
+        if (!validateLiveConfig(*next, fileDuration, error)) {
+            std::cout << "⚠ Config reload rejected: " << error << std::endl;
+            return;
+        }
+
+        for (const auto& name : restartOnlyChanges(settings, reloaded)) {
+            std::cout << "⚠ Config: " << name << " changed - takes effect after a restart" << std::endl;
+        }
+
+        RealtimeLogger::Level level;
+        RealtimeLogger::parseLevel(next->logLevel, level);
+        logger.setMinimumLevel(level);
+
+        if (audioFilePlayer->getGain() > next->gainLimit) {
+            audioFilePlayer->setGain(next->gainLimit);
+        }
+
+        liveConfig.publish(std::move(next));
+        std::cout << "🔄 Config reloaded from " << configPath << std::endl;
+    });
+
+    if (settings.configReload) {
+        if (configWatcher.start(configPath)) {
+            reactor.onReadable(configWatcher.getFd(), [&] {
+                if (configWatcher.readChanges()) {
+                    reactor.armTimer(configReloadTimer, 200);
                 }
-            } else {
-                jack_free(connections);
-            }
+            });
+        } else {
+            std::cerr << "Warning: " << configWatcher.getErrorMessage() << " (config reload disabled)" << std::endl;
         }
+    }
 
-        // Monitor buffer health (disabled - enable if debugging buffer issues)
-        // static int reportCount = 0;
-        // if (reportCount++ % 10000 == 0) // Every 10 seconds
-        // {
-        //     uint32_t used = audioFilePlayer->getBufferUsedSlots();
-        //     uint32_t total = audioFilePlayer->getBufferSize();
-        //     double percentage = (double)used / total * 100.0;
-        //     std::cout << "Buffer: " << used << "/" << total << " ("
-        //              << std::fixed << std::setprecision(1) << percentage << "%)" << std::endl;
-        // }
+    // Metrics endpoint - its own thread, reading only atomics
+    MetricsServer metricsServer;
+    if (settings.metricsEnabled) {
+        metricsServer.addCollector([&] (std::string& out) {
+            const auto& stats = audioFilePlayer->getStats();
+            uint32_t minFill = audioFilePlayer->takeMinBufferFill();
+            uint64_t observations = stats.fillObservations.load(std::memory_order_relaxed);
+            double bufferSize = audioFilePlayer->getBufferDepth();  // Ratios are of the current depth
+            double currentFill = audioFilePlayer->getBufferUsedSlots() / bufferSize;
+
+            MetricsServer::writeCounter(out, "player_underruns_total", "Blocks cut short because the FIFO ran dry",
+                                        (double)stats.underruns.load(std::memory_order_relaxed));
+            MetricsServer::writeCounter(out, "player_underrun_frames_total", "Frames of silence caused by underruns",
+                                        (double)stats.underrunFrames.load(std::memory_order_relaxed));
+            MetricsServer::writeCounter(out, "player_xruns_total", "Audio device xruns",
+                                        (double)backend->getXrunCount());
+            MetricsServer::writeCounter(out, "player_process_cycles_total", "Audio process callbacks",
+                                        (double)audioContext.processCycles.load(std::memory_order_relaxed));
+            MetricsServer::writeGauge(out, "player_buffer_depth_seconds", "Read-ahead the loader currently keeps buffered",
+                                      audioFilePlayer->getBufferDepthSeconds());
+            MetricsServer::writeGauge(out, "player_buffer_fill_ratio", "Current FIFO fill (0-1)", currentFill);
+            MetricsServer::writeGauge(out, "player_buffer_fill_min_ratio", "Lowest FIFO fill seen by the callback since the last scrape",
+                                      minFill == UINT32_MAX ? currentFill : minFill / bufferSize);
+            MetricsServer::writeGauge(out, "player_buffer_fill_avg_ratio", "Average FIFO fill seen by the callback since start",
+                                      observations ? stats.fillSampleSum.load(std::memory_order_relaxed) / (double)observations / bufferSize : 0.0);
+            MetricsServer::writeCounter(out, "player_bytes_read_total", "Audio bytes read from the file",
+                                        (double)stats.bytesRead.load(std::memory_order_relaxed));
+            MetricsServer::writeCounter(out, "player_read_errors_total", "Failed file reads",
+                                        (double)stats.readErrors.load(std::memory_order_relaxed));
+            MetricsServer::writeCounter(out, "player_loops_total", "Times the file wrapped to the start",
+                                        (double)stats.loops.load(std::memory_order_relaxed));
+            stats.refillLatency.writePrometheus(out, "player_refill_latency_seconds", "Time to read and buffer one chunk");
+            if (auto* readAhead = audioFilePlayer->getReadAhead()) {  // Not when playing from a non-file reader
+                MetricsServer::writeCounter(out, "player_io_block_reads_total", "Read-ahead blocks read from storage",
+                                            (double)readAhead->getBlockReads());
+                MetricsServer::writeCounter(out, "player_io_read_waits_total", "Times the decoder caught up with the read-ahead and waited",
+                                            (double)readAhead->getReadWaits());
+            }
+            MetricsServer::writeCounter(out, "player_failovers_total", "Switches to another copy of the audio file after a read failure",
+                                        (double)stats.failovers.load(std::memory_order_relaxed));
+            MetricsServer::writeGauge(out, "player_active_source", "Copy being read: 0 = audioFilePath, then replicaPaths in order",
+                                      (double)stats.activeSource.load(std::memory_order_relaxed));
+            MetricsServer::writeCounter(out, "player_seeks_total", "Seeks applied by the loader",
+                                        (double)stats.seeks.load(std::memory_order_relaxed));
+            stats.seekLatency.writePrometheus(out, "player_seek_latency_seconds",
+                                              "Seek request to its first frame played (seeks that play)");
+            MetricsServer::writeGauge(out, "player_position_seconds", "Position in the file that is audible now",
+                                      (double)audioFilePlayer->getAudibleFileFrame(backend->getOutputLatency())
+                                          / audioFilePlayer->getFileSampleRate());
+            MetricsServer::writeGauge(out, "player_output_latency_seconds", "Output latency reported by the audio backend",
+                                      backend->getOutputLatency() / backend->getSampleRate());
+            if (backend->getCpuLoad() >= 0) {
+                MetricsServer::writeGauge(out, "player_jack_dsp_load_percent", "JACK DSP load", backend->getCpuLoad());
+            }
+            audioContext.profiler.writePrometheus(out);
+
+            if (ltcGenerator) {
+                MetricsServer::writeCounter(out, "player_ltc_missed_blocks_total", "Blocks where LTC wasn't ready (after seeks)",
+                                            (double)ltcGenerator->getMissedFrameCount());
+            }
+            if (midiConnector) {
+                MetricsServer::writeCounter(out, "player_midi_reconnects_total", "MIDI controller (re)connections",
+                                            (double)midiConnector->getReconnectCount());
+            }
+            MetricsServer::writeCounter(out, "player_log_dropped_total", "Log records dropped because the log ring was full",
+                                        (double)logger.getDroppedCount());
+        });
+
+        if (metricsServer.start(settings.metricsAddress)) {
+            std::cout << "📈 Metrics: " << settings.metricsAddress << std::endl;
+        } else {
+            std::cerr << "Warning: " << metricsServer.getErrorMessage() << std::endl;
+        }
     }
 
+    // Run until Q / Ctrl+C - no polling, no periodic wakeups
+    reactor.run();
+
     std::cout << "\nPlayback finished." << std::endl;
+    std::cout << audioContext.profiler.getReport();
 
     // Restore terminal
     restoreTerminal(termState);
 
-    jack_deactivate(jackClient);
-    jack_client_close(jackClient);
+    metricsServer.stop();
+    if (midiConnector) midiConnector->stop();
+    backend->stop();
+    audioFilePlayer->stopLoading();  // Its callbacks notify the reactor, which closes that eventfd on the way out
+    if (ltcGenerator) ltcGenerator->stop();
+    logger.stop();
 
-    return 0;
+    return exitCode;
 }